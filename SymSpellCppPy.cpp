@@ -19,7 +19,12 @@ PYBIND11_MODULE(SymSpellCppPy, m)
 
            Info
            SuggestItem
+           SuggestionBatch
+           LookupCacheStats
+           LookupStats
            Verbosity
+           DistanceAlgorithm
+           PostingCodec
            SymSpell
     )pbdoc";
 
@@ -114,6 +119,66 @@ PYBIND11_MODULE(SymSpellCppPy, m)
         Gets or sets the frequency of the suggestion in the dictionary (a measure of how common the word is).
     )pbdoc");
 
+     py::class_<symspellcpppy::SuggestionBatch>(m, "SuggestionBatch", R"pbdoc(
+        Suggestions for a batch of words, as returned by SymSpell.lookup_batch.
+        Indexing gives the list of SuggestItem of one input word, in input order.
+    )pbdoc")
+         .def("__len__", &symspellcpppy::SuggestionBatch::Size, R"pbdoc(
+        Number of input words in the batch.
+    )pbdoc")
+         .def(
+             "__getitem__", [](const symspellcpppy::SuggestionBatch &batch, py::ssize_t index)
+             {
+                  if (index < 0)
+                       index += (py::ssize_t)batch.Size();
+                  if (index < 0 || (size_t)index >= batch.Size())
+                       throw py::index_error("SuggestionBatch index out of range");
+                  return std::vector<SuggestItem>(batch.Begin(index), batch.End(index));
+             },
+             R"pbdoc(
+        Suggestions of the input word at the given position.
+    )pbdoc",
+             py::arg("index"))
+         .def_readonly("suggestions", &symspellcpppy::SuggestionBatch::suggestions, R"pbdoc(
+        Suggestions of all distinct input words, one run after the other.
+    )pbdoc")
+         .def_readonly("offsets", &symspellcpppy::SuggestionBatch::offsets, R"pbdoc(
+        Start of the suggestions of every distinct input word, followed by the total number of suggestions.
+    )pbdoc")
+         .def_readonly("slots", &symspellcpppy::SuggestionBatch::slots, R"pbdoc(
+        Distinct input word of every input word, the suggestions of input word i are
+        suggestions[offsets[slots[i]]:offsets[slots[i] + 1]].
+    )pbdoc");
+
+     py::class_<LookupCache::Stats>(m, "LookupCacheStats", R"pbdoc(
+        Counters of the lookup cache, as returned by SymSpell.lookup_cache_stats.
+    )pbdoc")
+         .def_readonly("hits", &LookupCache::Stats::hits, R"pbdoc(
+        Number of lookups answered from the cache.
+    )pbdoc")
+         .def_readonly("misses", &LookupCache::Stats::misses, R"pbdoc(
+        Number of lookups that weren't cached.
+    )pbdoc")
+         .def_readonly("entries", &LookupCache::Stats::entries, R"pbdoc(
+        Number of cached lookup results.
+    )pbdoc")
+         .def_readonly("memory", &LookupCache::Stats::memory, R"pbdoc(
+        Estimated number of bytes taken by the cached lookup results.
+    )pbdoc");
+
+     py::class_<LookupStats>(m, "LookupStats", R"pbdoc(
+        Work done by the dictionary searches of lookups, as returned by SymSpell.lookup_stats.
+    )pbdoc")
+         .def_readonly("lookups", &LookupStats::lookups, R"pbdoc(
+        Number of lookups that searched the dictionary, lookups answered by the cache are not counted.
+    )pbdoc")
+         .def_readonly("signature_rejections", &LookupStats::signatureRejections, R"pbdoc(
+        Number of suggestions dropped because their letters alone put them too far from the input.
+    )pbdoc")
+         .def_readonly("distance_computations", &LookupStats::distanceComputations, R"pbdoc(
+        Number of suggestions whose edit distance to the input was computed.
+    )pbdoc");
+
      py::enum_<symspellcpppy::Verbosity>(m, "Verbosity")
          .value("TOP", symspellcpppy::Verbosity::Top, R"pbdoc(
           Top suggestion with the highest term frequency of the suggestions of smallest edit distance found.
@@ -123,18 +188,45 @@ PYBIND11_MODULE(SymSpellCppPy, m)
      )pbdoc")
          .value("ALL", symspellcpppy::Verbosity::All, R"pbdoc(
           All suggestions <= maxEditDistance, the suggestions are ordered by edit distance, then by term frequency (highest first)
+     )pbdoc")
+         .value("TOP_K", symspellcpppy::Verbosity::TopK, R"pbdoc(
+          The first k suggestions ALL would return, found without searching for the rest of them.
+     )pbdoc")
+         .export_values();
+
+     py::enum_<DistanceAlgorithm>(m, "DistanceAlgorithm")
+         .value("LEVENSHTEIN", DistanceAlgorithm::LevenshteinDistance, R"pbdoc(
+          Insertions, deletions and substitutions each count as one edit.
+     )pbdoc")
+         .value("DAMERAU_OSA", DistanceAlgorithm::DamerauOSADistance, R"pbdoc(
+          Optimal string alignment: like Levenshtein, and swapping two adjacent characters also counts as one edit.
+     )pbdoc")
+         .export_values();
+
+     py::enum_<PostingCodec>(m, "PostingCodec")
+         .value("RAW", PostingCodec::Raw, R"pbdoc(
+          Uncompressed word ids, the fastest lookups.
+     )pbdoc")
+         .value("VARINT", PostingCodec::Varint, R"pbdoc(
+          Gaps between word ids in varints, the least memory.
+     )pbdoc")
+         .value("STREAM_VBYTE", PostingCodec::StreamVByte, R"pbdoc(
+          Gaps between word ids in 1 to 4 bytes with SIMD decoding, between the two.
      )pbdoc")
          .export_values();
 
      py::class_<symspellcpppy::SymSpell>(m, "SymSpell", R"pbdoc(
         SymSpell is a class that provides fast and accurate spelling correction using Symmetric Delete spelling correction algorithm.
+        Lookups, loading and saving run without holding the GIL, so one instance can serve many Python threads at once.
+        The dictionary must not be modified while other threads are using it.
     )pbdoc")
-         .def(py::init<int, int, int, int, unsigned char>(), "SymSpell builder options",
+         .def(py::init<int, int, int, int, unsigned char, DistanceAlgorithm>(), "SymSpell builder options",
               py::arg("max_dictionary_edit_distance") = DEFAULT_MAX_EDIT_DISTANCE,
               py::arg("prefix_length") = DEFAULT_PREFIX_LENGTH,
               py::arg("count_threshold") = DEFAULT_COUNT_THRESHOLD,
               py::arg("initial_capacity") = DEFAULT_INITIAL_CAPACITY,
-              py::arg("compact_level") = DEFAULT_COMPACT_LEVEL)
+              py::arg("compact_level") = DEFAULT_COMPACT_LEVEL,
+              py::arg("distance_algorithm") = DEFAULT_DISTANCE_ALGORITHM)
          .def("word_count", &symspellcpppy::SymSpell::WordCount, R"pbdoc(
         Retrieves the total number of words in the dictionary.
     )pbdoc")
@@ -143,6 +235,9 @@ PYBIND11_MODULE(SymSpellCppPy, m)
     )pbdoc")
          .def("entry_count", &symspellcpppy::SymSpell::EntryCount, R"pbdoc(
         Retrieves the total number of delete words formed in the dictionary.
+    )pbdoc")
+         .def("distance_algorithm", &symspellcpppy::SymSpell::GetDistanceAlgorithm, R"pbdoc(
+        Retrieves the edit distance used to verify suggestions.
     )pbdoc")
          .def("count_threshold", &symspellcpppy::SymSpell::CountThreshold, R"pbdoc(
         Retrieves the frequency threshold to be considered as a valid word for spelling correction.
@@ -165,56 +260,125 @@ PYBIND11_MODULE(SymSpellCppPy, m)
          .def("load_bigram_dictionary", py::overload_cast<const std::string &, int, int, xchar>(&symspellcpppy::SymSpell::LoadBigramDictionary), R"pbdoc(
         Load multiple dictionary entries from a file of word/frequency count pairs.
     )pbdoc",
-              py::arg("corpus"), py::arg("term_index"), py::arg("count_index"), py::arg("separator") = DEFAULT_SEPARATOR_CHAR)
-         .def("load_dictionary", py::overload_cast<const std::string &, int, int, xchar>(&symspellcpppy::SymSpell::LoadDictionary), R"pbdoc(
+              py::arg("corpus"), py::arg("term_index"), py::arg("count_index"), py::arg("separator") = DEFAULT_SEPARATOR_CHAR,
+              py::call_guard<py::gil_scoped_release>())
+         .def("load_dictionary", py::overload_cast<const std::string &, int, int, xchar, int>(&symspellcpppy::SymSpell::LoadDictionary), R"pbdoc(
         Load multiple dictionary entries from a file of word/frequency count pairs.
+        The deletes are generated on `threads` threads (0 for one per hardware thread), the index is the same for any thread count.
     )pbdoc",
-              py::arg("corpus"), py::arg("term_index"), py::arg("count_index"), py::arg("separator") = DEFAULT_SEPARATOR_CHAR)
-         .def("create_dictionary", py::overload_cast<const std::string &>(&symspellcpppy::SymSpell::CreateDictionary), R"pbdoc(
+              py::arg("corpus"), py::arg("term_index"), py::arg("count_index"), py::arg("separator") = DEFAULT_SEPARATOR_CHAR,
+              py::arg("threads") = DEFAULT_BUILD_THREADS, py::call_guard<py::gil_scoped_release>())
+         .def("create_dictionary", py::overload_cast<const std::string &, int>(&symspellcpppy::SymSpell::CreateDictionary), R"pbdoc(
         Load multiple dictionary words from a file containing plain text.
+        The deletes are generated on `threads` threads (0 for one per hardware thread), the index is the same for any thread count.
     )pbdoc",
-              py::arg("corpus"))
+              py::arg("corpus"), py::arg("threads") = DEFAULT_BUILD_THREADS, py::call_guard<py::gil_scoped_release>())
          .def("purge_below_threshold_words", &symspellcpppy::SymSpell::PurgeBelowThresholdWords,
               "Remove all below threshold words from the dictionary.")
-         .def("lookup", py::overload_cast<const xstring &, symspellcpppy::Verbosity>(&symspellcpppy::SymSpell::Lookup), R"pbdoc(
+         .def("freeze", py::overload_cast<>(&symspellcpppy::SymSpell::Freeze), R"pbdoc(
+        Compile the dictionary and its bigrams into their compact read-only form, words can't be added or deleted afterwards.
+        The postings are stored with the codec of the compact level: uncompressed up to the default level, STREAM_VBYTE up to 10 and VARINT above.
+    )pbdoc",
+              py::call_guard<py::gil_scoped_release>())
+         .def("freeze", py::overload_cast<PostingCodec>(&symspellcpppy::SymSpell::Freeze), R"pbdoc(
+        Compile the dictionary and its bigrams into their compact read-only form, storing the postings with the given codec.
+
+        :param codec: Compressed postings take less memory and make lookups slower.
+    )pbdoc",
+              py::arg("codec"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("posting_codec", &symspellcpppy::SymSpell::GetPostingCodec, R"pbdoc(
+        The codec of the postings, the one freeze will use if the dictionary isn't frozen yet.
+    )pbdoc")
+         .def("is_frozen", &symspellcpppy::SymSpell::IsFrozen, R"pbdoc(
+        Whether the dictionary has been frozen.
+    )pbdoc")
+         .def("lookup", py::overload_cast<xstring_view, symspellcpppy::Verbosity>(&symspellcpppy::SymSpell::Lookup, py::const_), R"pbdoc(
         Find suggested spellings for a given input word, using the maximum
         edit distance specified during construction of the SymSpell dictionary.
      )pbdoc",
               py::arg("input"),
-              py::arg("verbosity"))
-         .def("lookup", py::overload_cast<const xstring &, symspellcpppy::Verbosity, int>(&symspellcpppy::SymSpell::Lookup), R"pbdoc(
+              py::arg("verbosity"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("lookup", py::overload_cast<xstring_view, symspellcpppy::Verbosity, int>(&symspellcpppy::SymSpell::Lookup, py::const_), R"pbdoc(
         Find suggested spellings for a given input word, using the maximum
         edit distance provided to the function.
      )pbdoc",
               py::arg("input"),
               py::arg("verbosity"),
-              py::arg("max_edit_distance"))
-         .def("lookup", py::overload_cast<const xstring &, symspellcpppy::Verbosity, int, bool>(&symspellcpppy::SymSpell::Lookup), R"pbdoc(
+              py::arg("max_edit_distance"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("lookup", py::overload_cast<xstring_view, symspellcpppy::Verbosity, int, bool>(&symspellcpppy::SymSpell::Lookup, py::const_), R"pbdoc(
         Find suggested spellings for a given input word, using the maximum\
         edit distance provided to the function and include input word in suggestions if no words within edit distance found.
      )pbdoc",
               py::arg("input"),
               py::arg("verbosity"),
               py::arg("max_edit_distance"),
-              py::arg("include_unknown"))
-         .def("lookup", py::overload_cast<const xstring &, symspellcpppy::Verbosity, int, bool, bool>(&symspellcpppy::SymSpell::Lookup), R"pbdoc(
+              py::arg("include_unknown"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("lookup", py::overload_cast<xstring_view, symspellcpppy::Verbosity, int, bool, bool, int>(&symspellcpppy::SymSpell::Lookup, py::const_), R"pbdoc(
         Find suggested spellings for a given input word, using the maximum
         edit distance provided to the function and include input word in suggestions if no words within edit distance found & preserve transfer casing.
+        With the TOP_K verbosity the best `k` suggestions are returned.
      )pbdoc",
               py::arg("input"),
               py::arg("verbosity"),
               py::arg("max_edit_distance") = DEFAULT_MAX_EDIT_DISTANCE,
               py::arg("include_unknown") = false,
-              py::arg("transfer_casing") = false)
-         .def("lookup_compound", py::overload_cast<const xstring &>(&symspellcpppy::SymSpell::LookupCompound),
+              py::arg("transfer_casing") = false,
+              py::arg("k") = DEFAULT_TOP_K,
+              py::call_guard<py::gil_scoped_release>())
+         .def(
+             "lookup_batch", [](const symspellcpppy::SymSpell &sym, const std::vector<xstring> &inputs,
+                                symspellcpppy::Verbosity verbosity, int maxEditDistance, int threads, bool includeUnknown,
+                                int k)
+             {
+                  py::gil_scoped_release release;
+                  std::vector<xstring_view> views(inputs.begin(), inputs.end());
+                  return sym.LookupBatch(views, verbosity, maxEditDistance, threads, includeUnknown, k);
+             },
+             R"pbdoc(
+        Find suggested spellings for a list of words in one call.
+        Repeated words are looked up once and the lookups run on several threads without holding the GIL.
+        Returns a SuggestionBatch whose i-th item holds the suggestions of the i-th word, as lookup would return them.
+     )pbdoc",
+             py::arg("inputs"),
+             py::arg("verbosity"),
+             py::arg("max_edit_distance") = DEFAULT_MAX_EDIT_DISTANCE,
+             py::arg("threads") = DEFAULT_LOOKUP_THREADS,
+             py::arg("include_unknown") = false,
+             py::arg("k") = DEFAULT_TOP_K)
+         .def("enable_lookup_cache", &symspellcpppy::SymSpell::EnableLookupCache, R"pbdoc(
+        Cache the results of lookup in about `memory_budget` bytes, 0 disables the cache.
+        The cache is shared by all threads, split into `shards` independently locked parts, and only admits results
+        that are asked for often enough. It is emptied whenever the dictionary changes.
+    )pbdoc",
+              py::arg("memory_budget"), py::arg("shards") = DEFAULT_LOOKUP_CACHE_SHARDS)
+         .def("lookup_cache_stats", &symspellcpppy::SymSpell::LookupCacheStats, R"pbdoc(
+        Hits, misses and size of the lookup cache, all zero when it isn't enabled.
+    )pbdoc")
+         .def("clear_lookup_cache", &symspellcpppy::SymSpell::ClearLookupCache, R"pbdoc(
+        Drop the cached lookup results.
+    )pbdoc")
+         .def("lookup_stats", &symspellcpppy::SymSpell::GetLookupStats, R"pbdoc(
+        Work done by the lookups since the instance was created or reset_lookup_stats was called, summed over all threads.
+        signature_rejections / (signature_rejections + distance_computations) is the share of edit distance computations
+        the letter signatures saved.
+    )pbdoc")
+         .def("reset_lookup_stats", &symspellcpppy::SymSpell::ResetLookupStats, R"pbdoc(
+        Set the lookup statistics back to zero.
+    )pbdoc")
+         .def("lookup_compound", py::overload_cast<xstring_view>(&symspellcpppy::SymSpell::LookupCompound, py::const_),
               R"pbdoc(
         LookupCompound supports compound-aware automatic spelling correction of multi-word input strings with three cases:
           1. Mistakenly inserted space into a correct word led to two incorrect terms.
           2. Mistakenly omitted space between two correct words led to one incorrect combined term.
           3. Multiple independent input terms with/without spelling errors.
     )pbdoc",
-              py::arg("input"))
-         .def("lookup_compound", py::overload_cast<const xstring &, int>(&symspellcpppy::SymSpell::LookupCompound),
+              py::arg("input"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("lookup_compound", py::overload_cast<xstring_view, int>(&symspellcpppy::SymSpell::LookupCompound, py::const_),
               R"pbdoc(
         LookupCompound supports compound-aware automatic spelling correction of multi-word input strings with three cases:
           1. Mistakenly inserted space into a correct word led to two incorrect terms.
@@ -222,8 +386,9 @@ PYBIND11_MODULE(SymSpellCppPy, m)
           3. Multiple independent input terms with/without spelling errors.
     )pbdoc",
               py::arg("input"),
-              py::arg("max_edit_distance"))
-         .def("lookup_compound", py::overload_cast<const xstring &, int, bool>(&symspellcpppy::SymSpell::LookupCompound),
+              py::arg("max_edit_distance"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("lookup_compound", py::overload_cast<xstring_view, int, bool>(&symspellcpppy::SymSpell::LookupCompound, py::const_),
               R"pbdoc(
         LookupCompound supports compound-aware automatic spelling correction of multi-word input strings with three cases:
           1. Mistakenly inserted space into a correct word led to two incorrect terms.
@@ -232,23 +397,26 @@ PYBIND11_MODULE(SymSpellCppPy, m)
     )pbdoc",
               py::arg("input"),
               py::arg("max_edit_distance"),
-              py::arg("transfer_casing"))
-         .def("word_segmentation", py::overload_cast<const xstring &>(&symspellcpppy::SymSpell::WordSegmentation),
+              py::arg("transfer_casing"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("word_segmentation", py::overload_cast<xstring_view>(&symspellcpppy::SymSpell::WordSegmentation, py::const_),
               R"pbdoc(
         WordSegmentation divides a string into words by inserting missing spaces at the appropriate positions.
         Misspelled words are corrected and do not affect segmentation.
         Existing spaces are allowed and considered for optimum segmentation.
     )pbdoc",
-              py::arg("input"))
-         .def("word_segmentation", py::overload_cast<const xstring &, int>(&symspellcpppy::SymSpell::WordSegmentation),
+              py::arg("input"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("word_segmentation", py::overload_cast<xstring_view, int>(&symspellcpppy::SymSpell::WordSegmentation, py::const_),
               R"pbdoc(
         WordSegmentation divides a string into words by inserting missing spaces at the appropriate positions.
         Misspelled words are corrected and do not affect segmentation.
         Existing spaces are allowed and considered for optimum segmentation.
     )pbdoc",
               py::arg("input"),
-              py::arg("max_edit_distance"))
-         .def("word_segmentation", py::overload_cast<const xstring &, int, int>(&symspellcpppy::SymSpell::WordSegmentation),
+              py::arg("max_edit_distance"),
+              py::call_guard<py::gil_scoped_release>())
+         .def("word_segmentation", py::overload_cast<xstring_view, int, int>(&symspellcpppy::SymSpell::WordSegmentation, py::const_),
               R"pbdoc(
         WordSegmentation divides a string into words by inserting missing spaces at the appropriate positions.
         Misspelled words are corrected and do not affect segmentation.
@@ -256,7 +424,8 @@ PYBIND11_MODULE(SymSpellCppPy, m)
     )pbdoc",
               py::arg("input"),
               py::arg("max_edit_distance"),
-              py::arg("max_segmentation_word_length"))
+              py::arg("max_segmentation_word_length"),
+              py::call_guard<py::gil_scoped_release>())
          .def(
              "save_pickle", [](symspellcpppy::SymSpell &sym, const std::string &filepath)
              {
@@ -268,7 +437,7 @@ PYBIND11_MODULE(SymSpellCppPy, m)
                          throw std::invalid_argument("Cannot save to file: " + filepath);
                      } },
              "Save internal representation to file",
-             py::arg("filepath"))
+             py::arg("filepath"), py::call_guard<py::gil_scoped_release>())
          .def(
              "load_pickle", [](symspellcpppy::SymSpell &sym, const std::string &filepath)
              {
@@ -280,13 +449,25 @@ PYBIND11_MODULE(SymSpellCppPy, m)
                          throw std::invalid_argument("Unable to load file from filepath: " + filepath);
                      } },
              "Load internal representation from file",
-             py::arg("filepath"))
+             py::arg("filepath"), py::call_guard<py::gil_scoped_release>())
+         .def("save_snapshot", &symspellcpppy::SymSpell::SaveSnapshot, R"pbdoc(
+        Freeze the dictionary and save it as a memory-mappable snapshot, bigrams included.
+    )pbdoc",
+              py::arg("filepath"), py::call_guard<py::gil_scoped_release>())
+         .def("load_snapshot", &symspellcpppy::SymSpell::LoadSnapshot, R"pbdoc(
+        Map a snapshot saved by save_snapshot read-only and use it in place, without deserialization.
+        Processes loading the same snapshot share its memory. The dictionary is frozen afterwards.
+    )pbdoc",
+              py::arg("filepath"), py::call_guard<py::gil_scoped_release>())
          .def(
              "save_pickle_bytes", [](symspellcpppy::SymSpell &sym)
              {
                     std::ostringstream binary_stream(std::ios::out | std::ios::binary);
-                    cereal::BinaryOutputArchive ar(binary_stream);
-                    ar(sym);
+                    {
+                         py::gil_scoped_release release;
+                         cereal::BinaryOutputArchive ar(binary_stream);
+                         ar(sym);
+                    }
 
                     return py::bytes(binary_stream.str()); },
              "Save internal representation to bytes")
@@ -304,6 +485,7 @@ PYBIND11_MODULE(SymSpellCppPy, m)
                     }
 
                     std::string const bytes_str(reinterpret_cast<char*>(buff.ptr), buff.size * buff.itemsize);
+                    py::gil_scoped_release release;
                     std::istringstream binary_stream(bytes_str, std::ios::in | std::ios::binary);
 
                     cereal::BinaryInputArchive ar(binary_stream);
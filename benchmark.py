@@ -6,10 +6,12 @@
 
 from symspellpy import SymSpell as SymSpellPy, Verbosity as VerbosityPy
 from SymSpellCppPy import SymSpell as SymSpellCpp, Verbosity as VerbosityCpp
+from concurrent.futures import ThreadPoolExecutor
 import pytest
 import os
 
 dict_path = "resources/frequency_dictionary_en_82_765.txt"
+queries_path = "tests/fortests/noisy_query_en_1000.txt"
 
 
 @pytest.mark.benchmark(
@@ -226,3 +228,43 @@ def test_lookup_compund_transfer_casing_symspellcpppy(benchmark):
                   "who couldn't read in sixth grade AND inspired him")
     results = benchmark(sym_spell.lookup_compound, typo, 2, transfer_casing=True)
     assert (results[0].term == correction)
+
+@pytest.mark.parametrize("threads", [1, 2, 4, 8])
+@pytest.mark.benchmark(
+    group="lookup_threads",
+    min_rounds=5,
+    disable_gc=True,
+    warmup=False
+)
+def test_lookup_threads_symspellcpppy(benchmark, threads):
+    # one shared instance queried from a thread pool, the lookups run without the GIL
+    sym_spell = SymSpellCpp(max_dictionary_edit_distance=2, prefix_length=7)
+    sym_spell.load_dictionary(dict_path, term_index=0, count_index=1, separator=" ")
+    with open(queries_path) as queries_file:
+        queries = [line.split(" ")[0] for line in queries_file]
+    chunks = [queries[i::threads] for i in range(threads)]
+
+    def lookup_chunk(chunk):
+        for query in chunk:
+            sym_spell.lookup(query, VerbosityCpp.CLOSEST, 2)
+
+    with ThreadPoolExecutor(max_workers=threads) as pool:
+        benchmark(lambda: list(pool.map(lookup_chunk, chunks)))
+    benchmark.extra_info["lookups_per_second"] = len(queries) / benchmark.stats.stats.mean
+
+@pytest.mark.parametrize("threads", [1, 2, 4, 8])
+@pytest.mark.benchmark(
+    group="lookup_threads",
+    min_rounds=5,
+    disable_gc=True,
+    warmup=False
+)
+def test_lookup_batch_symspellcpppy(benchmark, threads):
+    # the same queries as one lookup_batch call, a single round-trip through the bindings
+    sym_spell = SymSpellCpp(max_dictionary_edit_distance=2, prefix_length=7)
+    sym_spell.load_dictionary(dict_path, term_index=0, count_index=1, separator=" ")
+    with open(queries_path) as queries_file:
+        queries = [line.split(" ")[0] for line in queries_file]
+
+    benchmark(sym_spell.lookup_batch, queries, VerbosityCpp.CLOSEST, 2, threads=threads)
+    benchmark.extra_info["lookups_per_second"] = len(queries) / benchmark.stats.stats.mean
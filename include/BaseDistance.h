@@ -5,12 +5,13 @@
 #pragma once
 
 #include "iostream"
+#include <string_view>
 #include "Defines.h"
 
 
 class BaseDistance {
 public:
-    virtual double Distance(const xstring& string1, const xstring& string2) = 0;
+    virtual double Distance(xstring_view string1, xstring_view string2) = 0;
 
-    virtual double Distance(const xstring& string1, const xstring& string2, double maxDistance) = 0;
+    virtual double Distance(xstring_view string1, xstring_view string2, double maxDistance) = 0;
 };
@@ -5,11 +5,12 @@
 #pragma once
 
 #include "iostream"
+#include <string_view>
 #include "Defines.h"
 
 class BaseSimilarity {
 public:
-    virtual double Similarity(const xstring& string1, const xstring& string2) = 0;
+    virtual double Similarity(xstring_view string1, xstring_view string2) = 0;
 
-    virtual double Similarity(const xstring& string1, const xstring& string2, double minSimilarity) = 0;
+    virtual double Similarity(xstring_view string1, xstring_view string2, double minSimilarity) = 0;
 };
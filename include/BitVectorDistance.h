@@ -0,0 +1,182 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "Defines.h"
+#include "PatternMasks.h"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define BIT_VECTOR_DISTANCE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define BIT_VECTOR_DISTANCE_SSE2
+#endif
+
+// Bit-parallel edit distances between a pattern of at most 64 characters and any text.
+// Column j of the cost matrix is kept as two bit-vectors of vertical +1/-1 deltas (Myers' algorithm in Hyyrö's
+// formulation), so every text character costs a handful of word operations. With Transpositions the diagonal
+// zero deltas also take the swaps of adjacent characters, which gives Hyyrö's optimal string alignment distance.
+// Distances scores many texts against the same pattern, one text per SIMD lane: 4 with AVX2, 2 with SSE2.
+class BitVectorDistance {
+private:
+#if defined(BIT_VECTOR_DISTANCE_AVX2)
+    struct Lanes {
+        static constexpr int Width = 4;
+        __m256i v;
+
+        static Lanes Load(const uint64_t *values) { return {_mm256_loadu_si256((const __m256i *) values)}; }
+
+        static Lanes Fill(uint64_t value) { return {_mm256_set1_epi64x((long long) value)}; }
+
+        void Store(uint64_t *values) const { _mm256_storeu_si256((__m256i *) values, v); }
+
+        Lanes operator&(Lanes o) const { return {_mm256_and_si256(v, o.v)}; }
+
+        Lanes operator|(Lanes o) const { return {_mm256_or_si256(v, o.v)}; }
+
+        Lanes operator^(Lanes o) const { return {_mm256_xor_si256(v, o.v)}; }
+
+        Lanes operator+(Lanes o) const { return {_mm256_add_epi64(v, o.v)}; }
+
+        Lanes operator-(Lanes o) const { return {_mm256_sub_epi64(v, o.v)}; }
+
+        Lanes operator<<(int n) const { return {_mm256_slli_epi64(v, n)}; }
+
+        Lanes operator>>(int n) const { return {_mm256_srli_epi64(v, n)}; }
+
+        Lanes AndNot(Lanes o) const { return {_mm256_andnot_si256(v, o.v)}; }  // ~this & o
+    };
+#elif defined(BIT_VECTOR_DISTANCE_SSE2)
+    struct Lanes {
+        static constexpr int Width = 2;
+        __m128i v;
+
+        static Lanes Load(const uint64_t *values) { return {_mm_loadu_si128((const __m128i *) values)}; }
+
+        static Lanes Fill(uint64_t value) { return {_mm_set1_epi64x((long long) value)}; }
+
+        void Store(uint64_t *values) const { _mm_storeu_si128((__m128i *) values, v); }
+
+        Lanes operator&(Lanes o) const { return {_mm_and_si128(v, o.v)}; }
+
+        Lanes operator|(Lanes o) const { return {_mm_or_si128(v, o.v)}; }
+
+        Lanes operator^(Lanes o) const { return {_mm_xor_si128(v, o.v)}; }
+
+        Lanes operator+(Lanes o) const { return {_mm_add_epi64(v, o.v)}; }
+
+        Lanes operator-(Lanes o) const { return {_mm_sub_epi64(v, o.v)}; }
+
+        Lanes operator<<(int n) const { return {_mm_slli_epi64(v, n)}; }
+
+        Lanes operator>>(int n) const { return {_mm_srli_epi64(v, n)}; }
+
+        Lanes AndNot(Lanes o) const { return {_mm_andnot_si128(v, o.v)}; }  // ~this & o
+    };
+#endif
+
+    // costs of the last pattern row for texts..texts + Lanes::Width, texts past count are empty
+    template<bool Transpositions, class V>
+    static void ScoreLanes(const PatternMasks &masks, int patternLength, const xstring_view *texts, size_t count,
+                           uint64_t *costs) {
+        constexpr int Width = V::Width;
+        size_t longest = 0;
+        for (size_t l = 0; l < count; ++l)
+            longest = std::max(longest, texts[l].size());
+
+        const V ones = V::Fill(~uint64_t(0));
+        const V one = V::Fill(1);
+        const int lastRow = patternLength - 1;
+        V vp = ones, vn = V::Fill(0), d0 = V::Fill(0), prevMatches = V::Fill(0);
+        V cost = V::Fill((uint64_t) patternLength);
+        uint64_t laneMatches[Width], laneActive[Width];
+        for (size_t j = 0; j < longest; ++j) {
+            for (int l = 0; l < Width; ++l) {
+                bool active = (size_t) l < count && j < texts[l].size();
+                laneMatches[l] = active ? masks.Get(texts[l][j]) : 0;
+                laneActive[l] = active ? 1 : 0;
+            }
+            V matches = V::Load(laneMatches);
+            V active = V::Load(laneActive);
+            if (Transpositions) {
+                V transpositions = (d0.AndNot(matches) << 1) & prevMatches;
+                d0 = ((((matches & vp) + vp) ^ vp) | matches | vn | transpositions);
+                prevMatches = matches;
+            } else {
+                V x = matches | vn;
+                d0 = (((x & vp) + vp) ^ vp) | x;
+            }
+            V hp = vn | (d0 | vp).AndNot(ones);
+            V hn = vp & d0;
+            cost = cost + ((hp >> lastRow) & active) - ((hn >> lastRow) & active);
+            hp = (hp << 1) | one;
+            hn = hn << 1;
+            vp = hn | (d0 | hp).AndNot(ones);
+            vn = hp & d0;
+        }
+        cost.Store(costs);
+    }
+
+public:
+    static constexpr int MaxLength = PatternMasks::MaxLength;
+
+    /// <summary>Compute the edit distance between the pattern of masks and a text.</summary>
+    /// <param name="masks">Match vectors of the pattern.</param>
+    /// <param name="patternLength">Length of the pattern, 1 to MaxLength.</param>
+    /// <returns>The distance, or -1 if it is larger than maxDistance.</returns>
+    template<bool Transpositions>
+    static int Distance(const PatternMasks &masks, int patternLength, xstring_view text, int maxDistance) {
+        const uint64_t lastRow = uint64_t(1) << (patternLength - 1);
+        const int textLength = (int) text.size();
+        uint64_t vp = ~uint64_t(0), vn = 0, d0 = 0, prevMatches = 0;
+        int currentCost = patternLength;
+        for (int j = 0; j < textLength; ++j) {
+            uint64_t matches = masks.Get(text[j]);
+            if (Transpositions) {
+                uint64_t transpositions = ((~d0 & matches) << 1) & prevMatches;
+                d0 = (((matches & vp) + vp) ^ vp) | matches | vn | transpositions;
+                prevMatches = matches;
+            } else {
+                uint64_t x = matches | vn;
+                d0 = (((x & vp) + vp) ^ vp) | x;
+            }
+            uint64_t hp = vn | ~(d0 | vp);
+            uint64_t hn = vp & d0;
+            if (hp & lastRow) ++currentCost;
+            else if (hn & lastRow) --currentCost;
+            // the remaining characters can lower the cost by at most one each
+            if (currentCost - maxDistance > textLength - j - 1) return -1;
+            hp = (hp << 1) | 1;
+            hn <<= 1;
+            vp = hn | ~(d0 | hp);
+            vn = hp & d0;
+        }
+        return (currentCost <= maxDistance) ? currentCost : -1;
+    }
+
+    /// <summary>Compute the edit distances between the pattern of masks and many texts.</summary>
+    /// <param name="distances">Receives the distance of every text, or -1 where it is larger than maxDistance.</param>
+    template<bool Transpositions>
+    static void Distances(const PatternMasks &masks, int patternLength, const xstring_view *texts, size_t count,
+                          int maxDistance, int *distances) {
+        size_t i = 0;
+#if defined(BIT_VECTOR_DISTANCE_AVX2) || defined(BIT_VECTOR_DISTANCE_SSE2)
+        uint64_t costs[Lanes::Width];
+        while (count - i >= 2) {
+            size_t lanes = std::min(count - i, (size_t) Lanes::Width);
+            ScoreLanes<Transpositions, Lanes>(masks, patternLength, texts + i, lanes, costs);
+            for (size_t l = 0; l < lanes; ++l)
+                distances[i + l] = (costs[l] <= (uint64_t) maxDistance) ? (int) costs[l] : -1;
+            i += lanes;
+        }
+#endif
+        for (; i < count; ++i)
+            distances[i] = Distance<Transpositions>(masks, patternLength, texts[i], maxDistance);
+    }
+};
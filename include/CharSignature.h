@@ -0,0 +1,44 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include "Defines.h"
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif
+
+// 64 bit letter signature of a word. Characters are hashed into 32 buckets, bit b is set when bucket b holds
+// at least one character of the word and bit b + 32 when it holds at least two.
+// An edit operation removes at most one character from a word and adds at most one, so the characters one word
+// has more of than the other bound their edit distance from below, with or without transpositions. Counting
+// per bucket and only up to two can only lower that number, the bound holds for any alphabet.
+class CharSignature {
+private:
+    static int PopCount(uint64_t bits) {
+#ifdef _MSC_VER
+        return (int) __popcnt64(bits);
+#else
+        return __builtin_popcountll(bits);
+#endif
+    }
+
+public:
+    static uint64_t Of(xstring_view word) {
+        uint64_t signature = 0;
+        for (xchar c : word) {
+            uint64_t bit = uint64_t(1) << (((uint32_t) c * 2654435761u) >> 27);
+            signature |= ((signature & bit) << 32) | bit;
+        }
+        return signature;
+    }
+
+    /// <summary>A lower bound of the edit distance between the words of two signatures.</summary>
+    static int DistanceBound(uint64_t signature1, uint64_t signature2) {
+        return std::max(PopCount(signature1 & ~signature2), PopCount(signature2 & ~signature1));
+    }
+};
@@ -7,6 +7,8 @@
 #include "BaseDistance.h"
 #include "BaseSimilarity.h"
 #include "Helpers.h"
+#include "BitVectorDistance.h"
+#include "PatternMasks.h"
 #include <vector>
 #include <cmath>
 #include <climits>
@@ -16,6 +18,7 @@ class DamerauOSA : public BaseDistance, BaseSimilarity {
 private:
     std::vector<int> baseChar1Costs;
     std::vector<int> basePrevChar1Costs;
+    PatternMasks patternMasks;
 
 public:
     DamerauOSA() = default;
@@ -26,16 +29,18 @@ public:
         basePrevChar1Costs = std::vector<int>(expectedMaxstringLength, 0);
     }
 
-    double Distance(const xstring& string1, const xstring& string2) override {
+    double Distance(xstring_view string1, xstring_view string2) override {
         if (string1.empty()) return string2.size();
         if (string2.empty()) return string1.size();
 
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
 
         int len1, len2, start;
         Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
         if (len1 == 0) return len2;
+        if (len1 <= PatternMasks::MaxLength)
+            return BitParallelDistance(str1, str2, len1, len2, start, INT_MAX, patternMasks);
 
         if (len2 > baseChar1Costs.size()) {
             baseChar1Costs = std::vector<int>(len2, 0);
@@ -44,41 +49,26 @@ public:
         return Distance(str1, str2, len1, len2, start, baseChar1Costs, basePrevChar1Costs);
     }
 
-    double Distance(const xstring& string1, const xstring& string2, double maxDistance) override {
+    double Distance(xstring_view string1, xstring_view string2, double maxDistance) override {
         if (string1.empty() || string2.empty()) return Helpers::NullDistanceResults(string1, string2, maxDistance);
-        if (maxDistance <= 0) return (string1 == string2) ? 0 : -1;
         maxDistance = ceil(maxDistance);
-        int iMaxDistance = (maxDistance <= INT_MAX) ? (int) maxDistance : INT_MAX;
-
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
-
-        if (str2.size() - str1.size() > iMaxDistance) return -1;
-
-        int len1, len2, start;
-        Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
-        if (len1 == 0) return (len2 <= iMaxDistance) ? len2 : -1;
-
-        if (len2 > baseChar1Costs.size()) {
-            baseChar1Costs = std::vector<int>(len2, 0);
-            basePrevChar1Costs = std::vector<int>(len2, 0);
-        }
-        if (iMaxDistance < len2) {
-            return Distance(str1, str2, len1, len2, start, iMaxDistance, baseChar1Costs, basePrevChar1Costs);
-        }
-        return Distance(str1, str2, len1, len2, start, baseChar1Costs, basePrevChar1Costs);
+        int iMaxDistance = (maxDistance <= 0) ? 0 : (maxDistance <= INT_MAX) ? (int) maxDistance : INT_MAX;
+        return Distance(string1, string2, iMaxDistance, patternMasks, baseChar1Costs, basePrevChar1Costs);
     }
 
-    double Similarity(const xstring& string1, const xstring& string2) override {
+    double Similarity(xstring_view string1, xstring_view string2) override {
         if (string1.empty()) return (string2.empty()) ? 1 : 0;
         if (string2.empty()) return 0;
 
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
 
         int len1, len2, start;
         Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
         if (len1 == 0) return 1.0;
+        if (len1 <= PatternMasks::MaxLength)
+            return Helpers::ToSimilarity(BitParallelDistance(str1, str2, len1, len2, start, INT_MAX, patternMasks),
+                                         str2.size());
 
         if (len2 > baseChar1Costs.size()) {
             baseChar1Costs = std::vector<int>(len2, 0);
@@ -88,13 +78,13 @@ public:
                                      str2.size());
     }
 
-    double Similarity(const xstring& string1, const xstring& string2, double minSimilarity) override {
+    double Similarity(xstring_view string1, xstring_view string2, double minSimilarity) override {
         if (minSimilarity < 0 || minSimilarity > 1)
             throw std::invalid_argument("minSimilarity must be in range 0 to 1.0");
         if (string1.empty() || string2.empty()) return Helpers::NullSimilarityResults(string1, string2, minSimilarity);
 
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
 
         int iMaxDistance = Helpers::ToDistance(minSimilarity, str2.size());
         if (str2.size() - str1.size() > iMaxDistance) return -1;
@@ -103,6 +93,9 @@ public:
         int len1, len2, start;
         Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
         if (len1 == 0) return 1.0;
+        if (len1 <= PatternMasks::MaxLength)
+            return Helpers::ToSimilarity(
+                    BitParallelDistance(str1, str2, len1, len2, start, iMaxDistance, patternMasks), str2.size());
 
         if (len2 > baseChar1Costs.size()) {
             baseChar1Costs = std::vector<int>(len2, 0);
@@ -117,8 +110,36 @@ public:
                                      str2.size());
     }
 
+    /// <summary>Compute the distance between two strings using caller provided scratch storage.</summary>
+    /// <returns>The distance, or -1 if it is larger than maxDistance.</returns>
+    static int Distance(xstring_view string1, xstring_view string2, int maxDistance, PatternMasks &masks,
+                        std::vector<int> &char1Costs, std::vector<int> &prevChar1Costs) {
+        if (string1.empty() || string2.empty()) return Helpers::NullDistanceResults(string1, string2, maxDistance);
+        if (maxDistance <= 0) return (string1 == string2) ? 0 : -1;
+
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
+
+        if (str2.size() - str1.size() > maxDistance) return -1;
+
+        int len1, len2, start;
+        Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
+        if (len1 == 0) return (len2 <= maxDistance) ? len2 : -1;
+        if (len1 <= PatternMasks::MaxLength)
+            return BitParallelDistance(str1, str2, len1, len2, start, maxDistance, masks);
+
+        if (len2 > char1Costs.size()) {
+            char1Costs = std::vector<int>(len2, 0);
+            prevChar1Costs = std::vector<int>(len2, 0);
+        }
+        if (maxDistance < len2) {
+            return Distance(str1, str2, len1, len2, start, maxDistance, char1Costs, prevChar1Costs);
+        }
+        return Distance(str1, str2, len1, len2, start, char1Costs, prevChar1Costs);
+    }
+
     static int
-    Distance(const xstring& string1, const xstring& string2, int len1, int len2, int start, std::vector<int>& char1Costs,
+    Distance(xstring_view string1, xstring_view string2, int len1, int len2, int start, std::vector<int>& char1Costs,
              std::vector<int>& prevChar1Costs) {
         int j;
         for (j = 0; j < len2; j++) char1Costs[j] = j + 1;
@@ -155,7 +176,7 @@ public:
         return currentCost;
     }
 
-    static int Distance(const xstring& string1, const xstring& string2, int len1, int len2, int start, int maxDistance,
+    static int Distance(xstring_view string1, xstring_view string2, int len1, int len2, int start, int maxDistance,
                         std::vector<int>& char1Costs, std::vector<int>& prevChar1Costs) {
         int i, j;
         for (j = 0; j < maxDistance; j++)
@@ -200,4 +221,12 @@ public:
         }
         return (currentCost <= maxDistance) ? currentCost : -1;
     }
+
+    /// <summary>Hyyrö's bit-parallel optimal string alignment distance.</summary>
+    /// <remarks>The compared part of string1 must fit in PatternMasks::MaxLength characters.</remarks>
+    static int BitParallelDistance(xstring_view string1, xstring_view string2, int len1, int len2, int start,
+                                   int maxDistance, PatternMasks &masks) {
+        masks.Reset(string1.substr(start, len1));
+        return BitVectorDistance::Distance<true>(masks, len1, string2.substr(start, len2), maxDistance);
+    }
 };
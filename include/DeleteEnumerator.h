@@ -0,0 +1,152 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "Defines.h"
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif
+
+// Enumerates the distinct deletes of a word without building strings.
+// A delete is the bitmask of the word positions it removes. Its FNV-1a hash continues from the precomputed hash
+// of the untouched leading characters, so only the characters after the first removed one are hashed again.
+// Masks spelling the same string (e.g. removing either 'a' of "aab") are dropped through a scratch hash table.
+// All buffers are reused from word to word, enumerating doesn't allocate once they have grown.
+class DeleteEnumerator {
+public:
+    static constexpr int MaxWordLength = 64;
+
+    struct Delete {
+        uint64_t mask;  // positions of the word removed by this delete
+        uint32_t hash;  // FNV-1a hash of the delete string
+        int length;     // length of the delete string
+    };
+
+private:
+    xstring_view word;
+    uint64_t wordMask = 0;
+    std::vector<uint32_t> prefixHashes;  // prefixHashes[i] is the hash of word[0, i)
+    std::vector<Delete> deletes;
+    std::vector<uint32_t> slotStamps;    // a slot is in use when its stamp is the one of the current word
+    std::vector<uint32_t> slotDeletes;
+    uint32_t slotMask = 0;
+    uint32_t stamp = 0;
+
+    static int LowestBit(uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return (int) index;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    uint32_t HashOf(uint64_t mask) const {
+        if (mask == 0)
+            return prefixHashes[word.size()];
+        int first = LowestBit(mask);
+        uint32_t hash = prefixHashes[first];
+        uint64_t kept = wordMask & ~mask & ~((uint64_t(2) << first) - 1);
+        for (; kept != 0; kept &= kept - 1) {
+            hash ^= (uint32_t) word[LowestBit(kept)];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    bool SameString(uint64_t mask1, uint64_t mask2) const {
+        uint64_t kept1 = wordMask & ~mask1;
+        uint64_t kept2 = wordMask & ~mask2;
+        for (; kept1 != 0 && kept2 != 0; kept1 &= kept1 - 1, kept2 &= kept2 - 1) {
+            if (word[LowestBit(kept1)] != word[LowestBit(kept2)])
+                return false;
+        }
+        return kept1 == kept2;
+    }
+
+    void Grow() {
+        uint32_t capacity = slotStamps.empty() ? 64 : (uint32_t) slotStamps.size() * 2;
+        slotStamps.assign(capacity, 0);
+        slotDeletes.assign(capacity, 0);
+        slotMask = capacity - 1;
+        stamp = 1;
+        for (uint32_t i = 0; i < deletes.size(); ++i) {
+            uint32_t slot = deletes[i].hash & slotMask;
+            while (slotStamps[slot] == stamp) slot = (slot + 1) & slotMask;
+            slotStamps[slot] = stamp;
+            slotDeletes[slot] = i;
+        }
+    }
+
+public:
+    DeleteEnumerator() = default;
+
+    /// <summary>Start enumerating the deletes of a word, the word itself becomes delete 0.</summary>
+    /// <remarks>The word isn't copied and must outlive the enumeration.</remarks>
+    void Reset(xstring_view newWord) {
+        if (newWord.size() > MaxWordLength)
+            throw std::invalid_argument("Cannot enumerate the deletes of words longer than 64 characters");
+        word = newWord;
+        wordMask = word.size() == MaxWordLength ? ~uint64_t(0) : (uint64_t(1) << word.size()) - 1;
+        prefixHashes.resize(word.size() + 1);
+        prefixHashes[0] = 2166136261u;
+        for (size_t i = 0; i < word.size(); ++i)
+            prefixHashes[i + 1] = (prefixHashes[i] ^ (uint32_t) word[i]) * 16777619u;
+
+        deletes.clear();
+        if (slotStamps.empty() || ++stamp == 0)
+            Grow();
+        Add(0);
+    }
+
+    /// <summary>Add the delete removing the given positions of the word.</summary>
+    /// <returns>False if the delete spells a string that was already enumerated.</returns>
+    bool Add(uint64_t mask) {
+        if ((deletes.size() + 1) * 2 > slotStamps.size())
+            Grow();
+        uint32_t hash = HashOf(mask);
+        int length = (int) word.size() - (int) std::bitset<64>(mask).count();
+        uint32_t slot = hash & slotMask;
+        while (slotStamps[slot] == stamp) {
+            const Delete &other = deletes[slotDeletes[slot]];
+            if (other.hash == hash && other.length == length && SameString(other.mask, mask))
+                return false;
+            slot = (slot + 1) & slotMask;
+        }
+        slotStamps[slot] = stamp;
+        slotDeletes[slot] = (uint32_t) deletes.size();
+        deletes.push_back(Delete{mask, hash, length});
+        return true;
+    }
+
+    /// <summary>Add every delete removing one more character from a delete, the leftmost character first.</summary>
+    void AddDeletes(size_t index) {
+        uint64_t mask = deletes[index].mask;
+        for (uint64_t kept = wordMask & ~mask; kept != 0; kept &= kept - 1)
+            Add(mask | (kept & (~kept + 1)));
+    }
+
+    /// <summary>The delete consisting of the empty string.</summary>
+    uint64_t EmptyMask() const { return wordMask; }
+
+    size_t Size() const { return deletes.size(); }
+
+    const Delete &operator[](size_t index) const { return deletes[index]; }
+
+    int RemovedCount(const Delete &edit) const { return (int) word.size() - edit.length; }
+
+    /// <summary>Write the string of a delete into a buffer, reusing the buffer's storage.</summary>
+    void Materialize(const Delete &edit, xstring &out) const {
+        out.clear();
+        for (uint64_t kept = wordMask & ~edit.mask; kept != 0; kept &= kept - 1)
+            out.push_back(word[LowestBit(kept)]);
+    }
+};
@@ -0,0 +1,122 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define DICTIONARY_PARSER_SSE2
+#endif
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif
+
+// Splits dictionary text held in memory into lines and columns without copying it.
+// Lines and columns follow the getline rules the loaders always had: a missing newline at the end of the text
+// doesn't add an empty line, consecutive separators give empty columns, and a separator ending the line doesn't
+// add an empty column. Bytes are searched 16 at a time with SSE2 where available.
+class DictionaryParser {
+private:
+    static int LowestBit(unsigned int bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return (int) index;
+#else
+        return __builtin_ctz(bits);
+#endif
+    }
+
+    template<class CharT>
+    static bool IsSpace(CharT c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+public:
+    /// <summary>Find the first occurrence of a character.</summary>
+    /// <returns>A pointer to the character, or last if it doesn't occur.</returns>
+    template<class CharT>
+    static const CharT *Find(const CharT *first, const CharT *last, CharT c) {
+        while (first != last && *first != c) ++first;
+        return first;
+    }
+
+    static const char *Find(const char *first, const char *last, char c) {
+#ifdef DICTIONARY_PARSER_SSE2
+        const __m128i needle = _mm_set1_epi8(c);
+        while (last - first >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+            auto bits = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+            if (bits != 0)
+                return first + LowestBit(bits);
+            first += 16;
+        }
+#endif
+        while (first != last && *first != c) ++first;
+        return first;
+    }
+
+    /// <summary>Call visit with every line of the text, without the newline.</summary>
+    template<class CharT, class Visitor>
+    static void ForEachLine(const CharT *text, size_t length, const Visitor &visit) {
+        const CharT *last = text + length;
+        while (text != last) {
+            const CharT *newline = Find(text, last, (CharT) '\n');
+            visit(std::basic_string_view<CharT>(text, newline - text));
+            if (newline == last)
+                break;
+            text = newline + 1;
+        }
+    }
+
+    /// <summary>Split a line into its separator delimited columns, reusing the storage of columns.</summary>
+    template<class CharT>
+    static void SplitColumns(std::basic_string_view<CharT> line, CharT separator,
+                             std::vector<std::basic_string_view<CharT>> &columns) {
+        columns.clear();
+        const CharT *first = line.data();
+        const CharT *last = first + line.size();
+        while (first != last) {
+            const CharT *end = Find(first, last, separator);
+            columns.emplace_back(first, end - first);
+            if (end == last)
+                break;
+            first = end + 1;
+        }
+    }
+
+    /// <summary>Parse a base 10 count the way std::stoll does: leading white space and a sign are accepted,
+    /// parsing stops at the first character that isn't a digit.</summary>
+    /// <returns>False if the text doesn't start with a number.</returns>
+    /// <exception cref="std::out_of_range">The number doesn't fit in 64 bits.</exception>
+    template<class CharT>
+    static bool ParseCount(std::basic_string_view<CharT> text, int64_t &count) {
+        size_t i = 0;
+        while (i < text.size() && IsSpace(text[i])) ++i;
+        bool negative = false;
+        if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+            negative = text[i++] == '-';
+
+        const uint64_t limit = negative ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+        uint64_t value = 0;
+        size_t digitsStart = i;
+        for (; i < text.size(); ++i) {
+            auto digit = (uint64_t) (text[i] - '0');
+            if (digit > 9)
+                break;
+            if (value > (limit - digit) / 10)
+                throw std::out_of_range("stoll");
+            value = value * 10 + digit;
+        }
+        if (i == digitsStart)
+            return false;
+        count = negative ? (int64_t) (0 - value) : (int64_t) value;
+        return true;
+    }
+};
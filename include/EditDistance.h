@@ -5,9 +5,11 @@
 #pragma once
 
 #include <utility>
+#include <vector>
 
 #include "DamerauOSA.h"
 #include "Levenshtein.h"
+#include "PatternMasks.h"
 #include "Defines.h"
 #include "memory"
 
@@ -36,7 +38,34 @@ public:
         }
     }
 
-    int Compare(xstring string1, xstring string2, double maxDistance) {
-        return (int) this->distanceComparer->Distance(std::move(string1), std::move(string2), maxDistance);
+    int Compare(xstring_view string1, xstring_view string2, double maxDistance) {
+        return (int) this->distanceComparer->Distance(string1, string2, maxDistance);
+    }
+};
+
+// Scratch storage of the distance policies, reused from one comparison to the next.
+struct DistanceScratch {
+    PatternMasks masks;
+    std::vector<int> costs;
+    std::vector<int> prevCosts;
+};
+
+// Compile-time counterparts of EditDistance: code templated on a policy calls the distance kernels directly,
+// without the virtual call, the double conversion or per-call cost rows.
+struct DamerauOSAPolicy {
+    static constexpr DistanceAlgorithm Algorithm = DistanceAlgorithm::DamerauOSADistance;
+    static constexpr bool Transpositions = true;
+
+    static int Distance(xstring_view string1, xstring_view string2, int maxDistance, DistanceScratch &scratch) {
+        return DamerauOSA::Distance(string1, string2, maxDistance, scratch.masks, scratch.costs, scratch.prevCosts);
+    }
+};
+
+struct LevenshteinPolicy {
+    static constexpr DistanceAlgorithm Algorithm = DistanceAlgorithm::LevenshteinDistance;
+    static constexpr bool Transpositions = false;
+
+    static int Distance(xstring_view string1, xstring_view string2, int maxDistance, DistanceScratch &scratch) {
+        return Levenshtein::Distance(string1, string2, maxDistance, scratch.masks, scratch.costs);
     }
 };
@@ -0,0 +1,134 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Contiguous array of plain values that either owns its storage or borrows read-only memory,
+// e.g. a section of a memory-mapped snapshot. Reads always go through the same pointer, so code using
+// the array doesn't care where the values live. Only an owning array can be modified.
+template<class T>
+class FlatArray {
+    static_assert(std::is_trivially_copyable<T>::value, "FlatArray only holds trivially copyable values");
+
+private:
+    std::vector<T> owned;
+    const T *values = nullptr;
+    size_t count = 0;
+    bool borrowed = false;
+
+    void Sync() {
+        values = owned.data();
+        count = owned.size();
+    }
+
+public:
+    FlatArray() = default;
+
+    FlatArray(std::initializer_list<T> init) : owned(init) { Sync(); }
+
+    FlatArray(const FlatArray &other) : owned(other.owned), borrowed(other.borrowed) {
+        if (borrowed) {
+            values = other.values;
+            count = other.count;
+        } else {
+            Sync();
+        }
+    }
+
+    FlatArray(FlatArray &&other) noexcept: owned(std::move(other.owned)), values(other.values),
+                                           count(other.count), borrowed(other.borrowed) {
+        other.values = nullptr;
+        other.count = 0;
+        other.borrowed = false;
+    }
+
+    FlatArray &operator=(FlatArray other) noexcept {
+        owned.swap(other.owned);
+        std::swap(values, other.values);
+        std::swap(count, other.count);
+        std::swap(borrowed, other.borrowed);
+        return *this;
+    }
+
+    /// <summary>Point the array at memory owned by someone else, which must outlive the array.</summary>
+    void Borrow(const T *data, size_t size) {
+        owned.clear();
+        owned.shrink_to_fit();
+        values = data;
+        count = size;
+        borrowed = true;
+    }
+
+    bool Borrowed() const { return borrowed; }
+
+    const T *data() const { return values; }
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    const T *begin() const { return values; }
+
+    const T *end() const { return values + count; }
+
+    const T &operator[](size_t i) const { return values[i]; }
+
+    void Set(size_t i, const T &value) {
+        assert(!borrowed);
+        owned[i] = value;
+    }
+
+    void reserve(size_t capacity) {
+        assert(!borrowed);
+        owned.reserve(capacity);
+        Sync();
+    }
+
+    void clear() {
+        owned.clear();
+        borrowed = false;
+        Sync();
+    }
+
+    void assign(size_t size, const T &value) {
+        owned.assign(size, value);
+        borrowed = false;
+        Sync();
+    }
+
+    template<class It>
+    void append(It first, It last) {
+        assert(!borrowed);
+        owned.insert(owned.end(), first, last);
+        Sync();
+    }
+
+    void push_back(const T &value) {
+        assert(!borrowed);
+        owned.push_back(value);
+        Sync();
+    }
+
+    template<class Archive>
+    void save(Archive &ar) const {
+        if (borrowed)
+            ar(std::vector<T>(begin(), end()));
+        else
+            ar(owned);
+    }
+
+    template<class Archive>
+    void load(Archive &ar) {
+        ar(owned);
+        borrowed = false;
+        Sync();
+    }
+};
@@ -0,0 +1,185 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "FlatArray.h"
+#include "PerfectHash.h"
+#include "PostingCodec.h"
+#include "PostingList.h"
+#include "Snapshot.h"
+
+// Read-only compilation of the SymSpell delete index.
+// A minimal perfect hash of the delete hashes gives every bucket its own position i, and the postings of
+// position i are postings[bucketOffsets[i], bucketOffsets[i + 1]) of one contiguous array of word ids (CSR
+// layout). bucketHashes[i] holds the delete hash of the bucket, a delete hash that isn't in the index also maps
+// to some position and is rejected by it. The word ids refer to the dictionary's TermArena.
+// The postings of a bucket are sorted ascending. With a codec other than Raw they are stored compressed in
+// encodedPostings instead, and bucketOffsets are byte offsets into it.
+class FrozenIndex {
+private:
+    FlatArray<int32_t> bucketHashes;
+    FlatArray<uint32_t> bucketOffsets;
+    FlatArray<uint32_t> postings;
+    FlatArray<uint8_t> encodedPostings;
+    PerfectHash perfectHash;
+    PostingCodec codec = PostingCodec::Raw;
+
+    static constexpr PerfectHash::Sections DeletePerfectHashSections{
+            SnapshotSectionId::DeletePilots, SnapshotSectionId::DeleteRemap, SnapshotSectionId::DeleteHashParameters};
+
+    static uint64_t KeyOf(int32_t deleteHash) { return (uint32_t) deleteHash; }
+
+public:
+    typedef std::pair<const uint32_t *, const uint32_t *> PostingRange;
+
+    FrozenIndex() = default;
+
+    /// <summary>Compile the delete buckets.</summary>
+    /// <param name="newIds">The id every word id of the buckets is renumbered to.</param>
+    /// <param name="postingCodec">How the postings are stored.</param>
+    void Build(const std::unordered_map<int, PostingList> &deletes, const std::vector<uint32_t> &newIds,
+               PostingCodec postingCodec) {
+        Clear();
+        codec = postingCodec;
+        std::vector<const std::pair<const int, PostingList> *> buckets;
+        buckets.reserve(deletes.size());
+        for (const auto &bucket : deletes) {
+            if (!bucket.second.empty())
+                buckets.push_back(&bucket);
+        }
+        if (buckets.empty())
+            return;
+
+        // delete hashes are distinct map keys, so the perfect hash always builds
+        std::vector<uint64_t> keys(buckets.size());
+        for (size_t i = 0; i < buckets.size(); ++i)
+            keys[i] = KeyOf(buckets[i]->first);
+        if (!perfectHash.Build(keys))
+            throw std::logic_error("Delete hashes are not distinct");
+
+        // place every bucket first, the postings are then laid out in position order
+        std::vector<uint32_t> positionBuckets(buckets.size());
+        std::vector<int32_t> hashes(buckets.size());
+        size_t postingCount = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            uint32_t position = perfectHash.Index(keys[i]);
+            positionBuckets[position] = (uint32_t) i;
+            hashes[position] = buckets[i]->first;
+            postingCount += buckets[i]->second.size();
+        }
+        bucketHashes.append(hashes.begin(), hashes.end());
+
+        std::vector<uint32_t> offsets(buckets.size() + 1, 0);
+        std::vector<uint32_t> bucketIds;
+        std::vector<uint8_t> encoded;
+        if (codec == PostingCodec::Raw)
+            postings.reserve(postingCount);
+        for (size_t position = 0; position < buckets.size(); ++position) {
+            const PostingList &bucket = buckets[positionBuckets[position]]->second;
+            bucketIds.clear();
+            for (uint32_t id : bucket)
+                bucketIds.push_back(newIds[id]);
+            std::sort(bucketIds.begin(), bucketIds.end());
+            if (codec == PostingCodec::Raw) {
+                offsets[position] = (uint32_t) postings.size();
+                postings.append(bucketIds.begin(), bucketIds.end());
+            } else {
+                if (encoded.size() > UINT32_MAX - PostingCoder::Padding - 5 * bucketIds.size() - 5)
+                    throw std::length_error("Encoded postings are too large");
+                offsets[position] = (uint32_t) encoded.size();
+                PostingCoder::Encode(codec, bucketIds.data(), bucketIds.size(), encoded);
+            }
+        }
+        if (codec == PostingCodec::Raw) {
+            offsets[buckets.size()] = (uint32_t) postings.size();
+        } else {
+            offsets[buckets.size()] = (uint32_t) encoded.size();
+            encoded.resize(encoded.size() + PostingCoder::Padding, 0);
+            encodedPostings.append(encoded.begin(), encoded.end());
+        }
+        bucketOffsets.append(offsets.begin(), offsets.end());
+    }
+
+    void Clear() {
+        bucketHashes.clear();
+        bucketOffsets.clear();
+        postings.clear();
+        encodedPostings.clear();
+        perfectHash.Clear();
+        codec = PostingCodec::Raw;
+    }
+
+    bool Empty() const { return bucketOffsets.empty(); }
+
+    int EntryCount() const { return (int) bucketHashes.size(); }
+
+    PostingCodec Codec() const { return codec; }
+
+    /// <summary>Bytes taken by the postings.</summary>
+    size_t PostingBytes() const { return postings.size() * sizeof(uint32_t) + encodedPostings.size(); }
+
+    /// <summary>The postings of a delete hash.</summary>
+    /// <param name="scratch">Receives the decoded postings of compressed buckets, the range then points into
+    /// it.</param>
+    PostingRange Postings(int32_t deleteHash, std::vector<uint32_t> &scratch) const {
+        if (bucketHashes.empty())
+            return PostingRange(nullptr, nullptr);
+        uint32_t position = perfectHash.Index(KeyOf(deleteHash));
+        if (bucketHashes[position] != deleteHash)
+            return PostingRange(nullptr, nullptr);
+        if (codec == PostingCodec::Raw)
+            return PostingRange(postings.data() + bucketOffsets[position],
+                                postings.data() + bucketOffsets[position + 1]);
+        PostingCoder::Decode(codec, encodedPostings.data() + bucketOffsets[position],
+                             bucketOffsets[position + 1] - bucketOffsets[position], scratch);
+        return PostingRange(scratch.data(), scratch.data() + scratch.size());
+    }
+
+    void WriteSections(SnapshotWriter &writer) const {
+        writer.Add(SnapshotSectionId::DeleteBucketHashes, bucketHashes);
+        writer.Add(SnapshotSectionId::DeleteBucketOffsets, bucketOffsets);
+        writer.Add(SnapshotSectionId::DeletePostings, postings);
+        writer.Add(SnapshotSectionId::DeleteEncodedPostings, encodedPostings);
+        perfectHash.WriteSections(writer, DeletePerfectHashSections);
+    }
+
+    void ReadSections(const SnapshotReader &reader, uint32_t entryCount, uint32_t postingCodec) {
+        if (!PostingCoder::Valid(postingCodec))
+            throw std::invalid_argument("Corrupt snapshot: unknown posting codec");
+        codec = (PostingCodec) postingCodec;
+        reader.Borrow(SnapshotSectionId::DeleteBucketHashes, bucketHashes);
+        reader.Borrow(SnapshotSectionId::DeleteBucketOffsets, bucketOffsets);
+        reader.Borrow(SnapshotSectionId::DeletePostings, postings);
+        reader.Borrow(SnapshotSectionId::DeleteEncodedPostings, encodedPostings);
+        perfectHash.ReadSections(reader, DeletePerfectHashSections);
+        size_t count = bucketHashes.size();
+        if (count == 0 && bucketOffsets.empty() && perfectHash.Empty()) {
+            // snapshot of an empty dictionary
+            return;
+        }
+        size_t postingsEnd = codec == PostingCodec::Raw ? postings.size()
+                                                        : encodedPostings.size() - PostingCoder::Padding;
+        if (count != entryCount || perfectHash.Empty() || bucketOffsets.size() != count + 1 ||
+            (codec != PostingCodec::Raw && encodedPostings.size() < PostingCoder::Padding) ||
+            bucketOffsets[count] != postingsEnd)
+            throw std::invalid_argument("Corrupt snapshot: inconsistent delete sections");
+        for (size_t i = 0; i < count; ++i) {
+            if (bucketOffsets[i] > bucketOffsets[i + 1])
+                throw std::invalid_argument("Corrupt snapshot: inconsistent delete sections");
+        }
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(bucketHashes, bucketOffsets, postings, encodedPostings, perfectHash, codec);
+    }
+};
@@ -4,11 +4,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <sys/stat.h>
 #include "iostream"
 #include "Defines.h"
+#include "PostingList.h"
 #define DIFFLIB_ENABLE_EXTERN_MACROS
 #include <difflib.h>
 
@@ -35,17 +42,17 @@ public:
 
 class Helpers {
 public:
-    static int NullDistanceResults(const xstring &string1, const xstring &string2, double maxDistance) {
+    static int NullDistanceResults(xstring_view string1, xstring_view string2, double maxDistance) {
         if (string1.empty())
             return (string2.empty()) ? 0 : (string2.size() <= maxDistance) ? string2.size() : -1;
         return (string1.size() <= maxDistance) ? string1.size() : -1;
     }
 
-    static int NullSimilarityResults(const xstring &string1, const xstring &string2, double minSimilarity) {
+    static int NullSimilarityResults(xstring_view string1, xstring_view string2, double minSimilarity) {
         return (string1.empty() && string2.empty()) ? 1 : (0 <= minSimilarity) ? 0 : -1;
     }
 
-    static void PrefixSuffixPrep(const xstring& string1, const xstring& string2, int &len1, int &len2, int &start) {
+    static void PrefixSuffixPrep(xstring_view string1, xstring_view string2, int &len1, int &len2, int &start) {
         len2 = string2.size();
         len1 = string1.size(); // this is also the minimum length of the two strings
         // suffix common to both strings can be ignored
@@ -85,6 +92,11 @@ public:
         return a_lower;
     }
 
+    static void string_lower(xstring_view a, xstring& a_lower) {
+        a_lower.resize(a.size());
+        std::transform(a.begin(), a.end(), a_lower.begin(), to_xlower);
+    }
+
     static xstring string_upper(const xstring& a) {
         xstring a_upper = a;
         std::transform(a.begin(), a.end(), a_upper.begin(), to_xupper);
@@ -181,6 +193,40 @@ public:
 
         return response_string;
     }
+
+    /// <summary>Number of worker threads to use for a requested thread count, 0 means one per hardware thread.</summary>
+    static int ResolveThreadCount(int threads) {
+        if (threads < 0)
+            throw std::invalid_argument("threads cannot be negative");
+        if (threads == 0)
+            threads = (int) std::max(1u, std::thread::hardware_concurrency());
+        return threads;
+    }
+
+    /// <summary>Run body(0) .. body(threadCount - 1) concurrently, body(0) on the calling thread.</summary>
+    /// <remarks>The first exception thrown by any of the calls is rethrown once all of them have finished.</remarks>
+    template<class Body>
+    static void ParallelFor(int threadCount, const Body &body) {
+        std::vector<std::exception_ptr> errors(threadCount);
+        std::vector<std::thread> workers;
+        workers.reserve(threadCount > 0 ? threadCount - 1 : 0);
+        auto run = [&](int index) {
+            try {
+                body(index);
+            } catch (...) {
+                errors[index] = std::current_exception();
+            }
+        };
+        for (int i = 1; i < threadCount; ++i)
+            workers.emplace_back(run, i);
+        run(0);
+        for (auto &worker : workers)
+            worker.join();
+        for (auto &error : errors) {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
 };
 
 template<class T>
@@ -188,8 +234,8 @@ class ChunkArray {
 private:
     const int ChunkSize = 4096; //this must be a power of 2, otherwise can't optimize Row and Col functions
     const int DivShift = 12; // number of bits to shift right to do division by ChunkSize (the bit position of ChunkSize)
-    int Row(unsigned int index) { return index >> DivShift; } // same as index / ChunkSize
-    int Col(unsigned int index) { return index & (ChunkSize - 1); } //same as index % ChunkSize
+    int Row(unsigned int index) const { return index >> DivShift; } // same as index / ChunkSize
+    int Col(unsigned int index) const { return index & (ChunkSize - 1); } //same as index % ChunkSize
     int Capacity() { return Values.size() * ChunkSize; }
 
 public:
@@ -229,6 +275,10 @@ public:
         return Values[Row(index)][Col(index)];
     }
 
+    const T &At(unsigned int index) const {
+        return Values[Row(index)][Col(index)];
+    }
+
     void Set(unsigned int index, T &value) {
         Values[Row(index)][Col(index)] = value;
     }
@@ -236,7 +286,7 @@ public:
 
 class Node {
 public:
-    xstring suggestion;
+    uint32_t wordId;
     int next;
 };
 
@@ -266,7 +316,7 @@ public:
         Nodes.Clear();
     }
 
-    void Add(int deleteHash, xstring suggestion) {
+    void Add(int deleteHash, uint32_t wordId) {
         auto deletesFinded = Deletes.find(deleteHash);
         Entry newEntry{};
         newEntry.count = 0;
@@ -277,39 +327,30 @@ public:
         entry.first = Nodes.Count;
         Deletes[deleteHash] = entry;
         Node item;
-        item.suggestion = std::move(suggestion);
+        item.wordId = wordId;
         item.next = next; // 1st semantic errors, this should not be Nodes.Count
         Nodes.Add(item);
     }
 
-    void CommitTo(std::shared_ptr<std::unordered_map<int, std::vector<xstring>>> permanentDeletes) {
-        auto permanentDeletesEnd = permanentDeletes->end();
+    void CommitTo(std::shared_ptr<std::unordered_map<int, PostingList>> permanentDeletes) {
+        CommitTo(*permanentDeletes, [](int) { return true; });
+    }
+
+    /// <summary>Append the staged word ids of every delete hash accepted by the filter, the newest word first.</summary>
+    template<class Filter>
+    void CommitTo(std::unordered_map<int, PostingList> &permanentDeletes, const Filter &accept) const {
         for (auto &Delete : Deletes) {
-            auto permanentDeletesFinded = permanentDeletes->find(Delete.first);
-            std::vector<xstring> suggestions;
-            int i;
-            if (permanentDeletesFinded != permanentDeletesEnd) {
-                suggestions = permanentDeletesFinded->second;
-                i = suggestions.size();
-
-                std::vector<xstring> newSuggestions;
-                newSuggestions.reserve(suggestions.size() + Delete.second.count);
-                std::copy(suggestions.begin(), suggestions.end(), back_inserter(newSuggestions));
-                suggestions = newSuggestions;
-            } else {
-                i = 0;
-                int32_t count = Delete.second.count;
-                suggestions.reserve(count);
-            }
+            if (!accept(Delete.first))
+                continue;
+            PostingList &suggestions = permanentDeletes[Delete.first];
+            suggestions.reserve(suggestions.size() + Delete.second.count);
 
             int next = Delete.second.first;
             while (next >= 0) {
-                auto node = Nodes.At(next);
-                suggestions.push_back(node.suggestion);
+                const Node &node = Nodes.At(next);
+                suggestions.push_back(node.wordId);
                 next = node.next;
-                ++i;
             }
-            (*permanentDeletes)[Delete.first] = suggestions;
         }
     }
 };
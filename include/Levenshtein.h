@@ -7,6 +7,8 @@
 #include "BaseDistance.h"
 #include "BaseSimilarity.h"
 #include "Helpers.h"
+#include "BitVectorDistance.h"
+#include "PatternMasks.h"
 #include "Defines.h"
 #include <vector>
 #include <cmath>
@@ -16,6 +18,7 @@
 class Levenshtein : public BaseDistance, BaseSimilarity {
 private:
     std::vector<int> baseChar1Costs;
+    PatternMasks patternMasks;
 
 public:
 
@@ -26,57 +29,44 @@ public:
         baseChar1Costs = std::vector<int>(expectedMaxstringLength, 0);
     }
 
-    double Distance(const xstring& string1, const xstring& string2) override {
+    double Distance(xstring_view string1, xstring_view string2) override {
         if (string1.empty()) return string2.size();
         if (string2.empty()) return string1.size();
 
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
 
         int len1, len2, start;
         Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
         if (len1 == 0) return len2;
+        if (len1 <= PatternMasks::MaxLength)
+            return BitParallelDistance(str1, str2, len1, len2, start, INT_MAX, patternMasks);
 
         return Distance(str1, str2, len1, len2, start,
                         (baseChar1Costs = (len2 <= baseChar1Costs.size()) ? baseChar1Costs : std::vector<int>(len2,
                                                                                                               0)));
     }
 
-    double Distance(const xstring& string1, const xstring& string2, double maxDistance) override {
+    double Distance(xstring_view string1, xstring_view string2, double maxDistance) override {
         if (string1.empty() || string2.empty()) return Helpers::NullDistanceResults(string1, string2, maxDistance);
-        if (maxDistance <= 0) return (string1 == string2) ? 0 : -1;
         maxDistance = ceil(maxDistance);
-        int iMaxDistance = (maxDistance <= INT_MAX) ? (int) maxDistance : INT_MAX;
-
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
-
-        if (str2.size() - str1.size() > iMaxDistance) return -1;
-
-        int len1, len2, start;
-        Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
-        if (len1 == 0) return (len2 <= iMaxDistance) ? len2 : -1;
-
-        if (iMaxDistance < len2) {
-            return Distance(str1, str2, len1, len2, start, iMaxDistance,
-                            (baseChar1Costs = (len2 <= baseChar1Costs.size()) ? baseChar1Costs : std::vector<int>(len2,
-                                                                                                                  0)));
-        }
-        return Distance(str1, str2, len1, len2, start,
-                        (baseChar1Costs = (len2 <= baseChar1Costs.size()) ? baseChar1Costs : std::vector<int>(len2,
-                                                                                                              0)));
+        int iMaxDistance = (maxDistance <= 0) ? 0 : (maxDistance <= INT_MAX) ? (int) maxDistance : INT_MAX;
+        return Distance(string1, string2, iMaxDistance, patternMasks, baseChar1Costs);
     }
 
-    double Similarity(const xstring& string1, const xstring& string2) override {
+    double Similarity(xstring_view string1, xstring_view string2) override {
         if (string1.empty()) return (string2.empty()) ? 1 : 0;
         if (string2.empty()) return 0;
 
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
 
         int len1, len2, start;
         Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
         if (len1 == 0) return 1.0;
+        if (len1 <= PatternMasks::MaxLength)
+            return Helpers::ToSimilarity(BitParallelDistance(str1, str2, len1, len2, start, INT_MAX, patternMasks),
+                                         str2.size());
 
         return Helpers::ToSimilarity(Distance(str1, str2, len1, len2, start,
                                               (baseChar1Costs = (len2 <= baseChar1Costs.size()) ? baseChar1Costs
@@ -85,13 +75,13 @@ public:
                                      str2.size());
     }
 
-    double Similarity(const xstring& string1, const xstring& string2, double minSimilarity) override {
+    double Similarity(xstring_view string1, xstring_view string2, double minSimilarity) override {
         if (minSimilarity < 0 || minSimilarity > 1)
             throw std::invalid_argument("minSimilarity must be in range 0 to 1.0");
         if (string1.empty() || string2.empty()) return Helpers::NullSimilarityResults(string1, string2, minSimilarity);
 
-        const xstring& str1 = (string1.size() > string2.size()) ? string2 : string1;
-        const xstring& str2 = (string1.size() > string2.size()) ? string1 : string2;
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
 
         int iMaxDistance = Helpers::ToDistance(minSimilarity, str2.size());
         if (str2.size() - str1.size() > iMaxDistance) return -1;
@@ -100,6 +90,9 @@ public:
         int len1, len2, start;
         Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
         if (len1 == 0) return 1.0;
+        if (len1 <= PatternMasks::MaxLength)
+            return Helpers::ToSimilarity(
+                    BitParallelDistance(str1, str2, len1, len2, start, iMaxDistance, patternMasks), str2.size());
 
         if (iMaxDistance < len2) {
             return Helpers::ToSimilarity(Distance(str1, str2, len1, len2, start, iMaxDistance,
@@ -114,9 +107,34 @@ public:
                                      str2.size());
     }
 
+    /// <summary>Compute the distance between two strings using caller provided scratch storage.</summary>
+    /// <returns>The distance, or -1 if it is larger than maxDistance.</returns>
+    static int Distance(xstring_view string1, xstring_view string2, int maxDistance, PatternMasks &masks,
+                        std::vector<int> &char1Costs) {
+        if (string1.empty() || string2.empty()) return Helpers::NullDistanceResults(string1, string2, maxDistance);
+        if (maxDistance <= 0) return (string1 == string2) ? 0 : -1;
+
+        xstring_view str1 = (string1.size() > string2.size()) ? string2 : string1;
+        xstring_view str2 = (string1.size() > string2.size()) ? string1 : string2;
+
+        if (str2.size() - str1.size() > maxDistance) return -1;
+
+        int len1, len2, start;
+        Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
+        if (len1 == 0) return (len2 <= maxDistance) ? len2 : -1;
+        if (len1 <= PatternMasks::MaxLength)
+            return BitParallelDistance(str1, str2, len1, len2, start, maxDistance, masks);
+
+        if (len2 > char1Costs.size())
+            char1Costs = std::vector<int>(len2, 0);
+        if (maxDistance < len2)
+            return Distance(str1, str2, len1, len2, start, maxDistance, char1Costs);
+        return Distance(str1, str2, len1, len2, start, char1Costs);
+    }
+
     static int
-    Distance(const xstring& string1, const xstring& string2, int len1, int len2, int start, std::vector<int> &char1Costs) {
-        for (int j = 0; j < len2;) char1Costs[j] = ++j;
+    Distance(xstring_view string1, xstring_view string2, int len1, int len2, int start, std::vector<int> &char1Costs) {
+        for (int j = 0; j < len2; j++) char1Costs[j] = j + 1;
         int currentCharCost = 0;
         if (start == 0) {
             for (int i = 0; i < len1; ++i) {
@@ -154,10 +172,10 @@ public:
         return currentCharCost;
     }
 
-    static int Distance(const xstring& string1, const xstring& string2, int len1, int len2, int start, int maxDistance,
+    static int Distance(xstring_view string1, xstring_view string2, int len1, int len2, int start, int maxDistance,
                         std::vector<int> &char1Costs) {
         int i, j;
-        for (j = 0; j < maxDistance;) char1Costs[j] = ++j;
+        for (j = 0; j < maxDistance; j++) char1Costs[j] = j + 1;
         for (; j < len2;) char1Costs[j++] = maxDistance + 1;
         int lenDiff = len2 - len1;
         int jStartOffset = maxDistance - lenDiff;
@@ -205,4 +223,12 @@ public:
         }
         return (currentCost <= maxDistance) ? currentCost : -1;
     }
+
+    /// <summary>Myers' bit-parallel Levenshtein distance.</summary>
+    /// <remarks>The compared part of string1 must fit in PatternMasks::MaxLength characters.</remarks>
+    static int BitParallelDistance(xstring_view string1, xstring_view string2, int len1, int len2, int start,
+                                   int maxDistance, PatternMasks &masks) {
+        masks.Reset(string1.substr(start, len1));
+        return BitVectorDistance::Distance<false>(masks, len1, string2.substr(start, len2), maxDistance);
+    }
 };
@@ -0,0 +1,285 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Defines.h"
+#include "Helpers.h"
+
+// Cache of lookup results with a memory budget, shared by any number of threads.
+// Keys are spread over shards that each have their own lock. Every shard keeps its entries the W-TinyLFU way:
+// new entries go into a small LRU window, and an entry leaving the window only gets into the main region if it
+// has been asked for more often than the main region's eviction victim. The main region is a segmented LRU whose
+// probation segment takes new entries and whose protected segment takes the entries hit again. The frequencies
+// come from a count-min sketch of 4 bit counters that are halved periodically, so old popularity fades away.
+class LookupCache {
+public:
+    /// <summary>Everything a lookup result depends on besides the dictionary.</summary>
+    struct Key {
+        xstring_view input;
+        int verbosity;
+        int maxEditDistance;
+        bool includeUnknown;
+        bool transferCasing;
+        int k;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t entries = 0;
+        size_t memory = 0;  // estimated bytes held by the entries
+    };
+
+private:
+    enum Region {
+        Window, Probation, Protected, RegionCount
+    };
+
+    struct Entry {
+        uint64_t hash;
+        xstring input;
+        int verbosity;
+        int maxEditDistance;
+        bool includeUnknown;
+        bool transferCasing;
+        int k;
+        Region region;
+        size_t memory;
+        std::vector<SuggestItem> suggestions;
+
+        bool Matches(const Key &key) const {
+            return verbosity == key.verbosity && maxEditDistance == key.maxEditDistance &&
+                   includeUnknown == key.includeUnknown && transferCasing == key.transferCasing && k == key.k &&
+                   xstring_view(input) == key.input;
+        }
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // Count-min sketch of how often keys were asked for, 4 rows of counters saturating at 15.
+    class FrequencySketch {
+    private:
+        static constexpr int Rows = 4;
+        std::vector<uint8_t> counters;
+        uint32_t widthMask = 0;
+        uint32_t additions = 0;
+        uint32_t sampleSize = 0;
+
+        size_t IndexOf(uint64_t hash, int row) const {
+            static constexpr uint64_t seeds[Rows] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+                                                     0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+            uint64_t h = (hash ^ (hash >> 29)) * seeds[row];
+            return (size_t) row * (widthMask + 1) + ((uint32_t) (h >> 32) & widthMask);
+        }
+
+    public:
+        void Resize(size_t expectedEntries) {
+            uint32_t width = 64;
+            while (width < expectedEntries && width < (1u << 24)) width <<= 1;
+            counters.assign((size_t) Rows * width, 0);
+            widthMask = width - 1;
+            additions = 0;
+            sampleSize = width * 10;
+        }
+
+        void Increment(uint64_t hash) {
+            for (int row = 0; row < Rows; ++row) {
+                uint8_t &counter = counters[IndexOf(hash, row)];
+                if (counter < 15) ++counter;
+            }
+            if (++additions == sampleSize) {
+                for (uint8_t &counter : counters) counter >>= 1;
+                additions /= 2;
+            }
+        }
+
+        int Frequency(uint64_t hash) const {
+            int frequency = 15;
+            for (int row = 0; row < Rows; ++row)
+                frequency = std::min(frequency, (int) counters[IndexOf(hash, row)]);
+            return frequency;
+        }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, EntryList::iterator> index;  // key hash -> entry
+        EntryList regions[RegionCount];                           // most recently used first
+        size_t memory[RegionCount] = {};
+        size_t budget[RegionCount] = {};
+        FrequencySketch sketch;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<bool> populated{false};
+
+    static uint64_t HashOf(const Key &key) {
+        uint64_t hash = std::hash<xstring_view>{}(key.input);
+        uint64_t options = (uint64_t) (uint32_t) key.verbosity | (uint64_t) (uint32_t) key.maxEditDistance << 8 |
+                           (uint64_t) key.includeUnknown << 40 | (uint64_t) key.transferCasing << 41 |
+                           (uint64_t) (uint32_t) key.k << 42;
+        hash ^= options + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    Shard &ShardOf(uint64_t hash) const {
+        return *shards[(hash >> 40) % shards.size()];
+    }
+
+    static size_t MemoryOf(const Entry &entry) {
+        size_t memory = sizeof(Entry) + sizeof(std::pair<const uint64_t, EntryList::iterator>) + 4 * sizeof(void *) +
+                        entry.input.size() * sizeof(xchar) + entry.suggestions.size() * sizeof(SuggestItem);
+        for (const SuggestItem &suggestion : entry.suggestions)
+            memory += suggestion.term.size() * sizeof(xchar);
+        return memory;
+    }
+
+    static void MoveTo(Shard &shard, EntryList::iterator entry, Region region) {
+        shard.memory[entry->region] -= entry->memory;
+        shard.memory[region] += entry->memory;
+        shard.regions[region].splice(shard.regions[region].begin(), shard.regions[entry->region], entry);
+        entry->region = region;
+    }
+
+    static void Evict(Shard &shard, EntryList::iterator entry) {
+        shard.index.erase(entry->hash);
+        shard.memory[entry->region] -= entry->memory;
+        shard.regions[entry->region].erase(entry);
+    }
+
+    static void Touch(Shard &shard, EntryList::iterator entry) {
+        if (entry->region != Probation) {
+            MoveTo(shard, entry, entry->region);
+            return;
+        }
+        MoveTo(shard, entry, Protected);
+        while (shard.memory[Protected] > shard.budget[Protected] && shard.regions[Protected].size() > 1)
+            MoveTo(shard, std::prev(shard.regions[Protected].end()), Probation);
+    }
+
+    // entries leaving the window compete with the probation victims for the room in the main region
+    static void Balance(Shard &shard) {
+        const size_t mainBudget = shard.budget[Probation] + shard.budget[Protected];
+        while (shard.memory[Window] > shard.budget[Window]) {
+            auto candidate = std::prev(shard.regions[Window].end());
+            MoveTo(shard, candidate, Probation);
+            while (shard.memory[Probation] + shard.memory[Protected] > mainBudget) {
+                auto victim = std::prev(shard.regions[Probation].end());
+                if (victim != candidate &&
+                    shard.sketch.Frequency(candidate->hash) > shard.sketch.Frequency(victim->hash)) {
+                    Evict(shard, victim);
+                } else {
+                    Evict(shard, candidate);
+                    break;
+                }
+            }
+        }
+    }
+
+public:
+    /// <summary>Create a cache holding entries of about memoryBudget bytes in total.</summary>
+    /// <param name="shardCount">Number of independently locked shards, more shards mean less lock contention.</param>
+    LookupCache(size_t memoryBudget, int shardCount) {
+        if (shardCount < 1)
+            throw std::invalid_argument("shards must be larger than 0");
+        size_t shardBudget = memoryBudget / shardCount;
+        for (int i = 0; i < shardCount; ++i) {
+            auto shard = std::make_unique<Shard>();
+            shard->budget[Window] = shardBudget / 100;
+            size_t mainBudget = shardBudget - shard->budget[Window];
+            shard->budget[Protected] = mainBudget / 5 * 4;
+            shard->budget[Probation] = mainBudget - shard->budget[Protected];
+            // sized for entries of a few hundred bytes
+            shard->sketch.Resize(shardBudget / 256);
+            shards.push_back(std::move(shard));
+        }
+    }
+
+    /// <summary>Copy the cached suggestions of a key into suggestions.</summary>
+    /// <returns>False if the key isn't cached, suggestions are left untouched then.</returns>
+    bool Find(const Key &key, std::vector<SuggestItem> &suggestions) {
+        uint64_t hash = HashOf(key);
+        Shard &shard = ShardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.sketch.Increment(hash);
+        auto found = shard.index.find(hash);
+        if (found == shard.index.end() || !found->second->Matches(key)) {
+            ++shard.misses;
+            return false;
+        }
+        ++shard.hits;
+        Touch(shard, found->second);
+        suggestions.assign(found->second->suggestions.begin(), found->second->suggestions.end());
+        return true;
+    }
+
+    /// <summary>Offer the suggestions of a key to the cache, which only keeps them if they are asked for often
+    /// enough.</summary>
+    void Insert(const Key &key, const std::vector<SuggestItem> &suggestions) {
+        uint64_t hash = HashOf(key);
+        Shard &shard = ShardOf(hash);
+        Entry entry{hash, xstring(key.input), key.verbosity, key.maxEditDistance, key.includeUnknown,
+                    key.transferCasing, key.k, Window, 0, suggestions};
+        entry.memory = MemoryOf(entry);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (entry.memory > shard.budget[Probation] + shard.budget[Protected])
+            return;
+        // another thread may have cached the key meanwhile, or a different key with the same hash is cached
+        auto found = shard.index.find(hash);
+        if (found != shard.index.end())
+            Evict(shard, found->second);
+        shard.regions[Window].push_front(std::move(entry));
+        shard.memory[Window] += shard.regions[Window].front().memory;
+        shard.index.emplace(hash, shard.regions[Window].begin());
+        Balance(shard);
+        if (!populated.load(std::memory_order_relaxed))
+            populated.store(true, std::memory_order_relaxed);
+    }
+
+    /// <summary>Drop every entry, the frequencies and the hit and miss counts are kept.</summary>
+    void Clear() {
+        if (!populated.exchange(false))
+            return;
+        for (auto &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->index.clear();
+            for (int region = 0; region < RegionCount; ++region) {
+                shard->regions[region].clear();
+                shard->memory[region] = 0;
+            }
+        }
+    }
+
+    Stats GetStats() const {
+        Stats stats;
+        for (auto &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            stats.hits += shard->hits;
+            stats.misses += shard->misses;
+            stats.entries += shard->index.size();
+            for (size_t memory : shard->memory)
+                stats.memory += memory;
+        }
+        return stats;
+    }
+};
@@ -0,0 +1,103 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Defines.h"
+#include "DeleteEnumerator.h"
+#include "EditDistance.h"
+#include "Helpers.h"
+#include "LookupStats.h"
+#include "PatternMasks.h"
+
+// Set of word ids for the suggestions a lookup has already seen, an open-addressing table cleared in constant
+// time: a slot is in use when its stamp is the one of the current lookup.
+class IdSet {
+private:
+    std::vector<uint32_t> slotStamps;
+    std::vector<uint32_t> slotIds;
+    uint32_t slotMask = 0;
+    uint32_t stamp = 0;
+    uint32_t size = 0;
+
+    uint32_t HomeSlot(uint32_t id) const {
+        return (id * 2654435761u) & slotMask;
+    }
+
+    void Grow() {
+        std::vector<uint32_t> oldStamps, oldIds;
+        oldStamps.swap(slotStamps);
+        oldIds.swap(slotIds);
+        uint32_t oldStamp = stamp;
+        uint32_t capacity = oldStamps.empty() ? 64 : (uint32_t) oldStamps.size() * 2;
+        slotStamps.assign(capacity, 0);
+        slotIds.assign(capacity, 0);
+        slotMask = capacity - 1;
+        stamp = 1;
+        for (size_t i = 0; i < oldStamps.size(); ++i) {
+            if (oldStamps[i] != oldStamp)
+                continue;
+            uint32_t slot = HomeSlot(oldIds[i]);
+            while (slotStamps[slot] == stamp) slot = (slot + 1) & slotMask;
+            slotStamps[slot] = stamp;
+            slotIds[slot] = oldIds[i];
+        }
+    }
+
+public:
+    IdSet() = default;
+
+    void Clear() {
+        size = 0;
+        if (slotStamps.empty()) {
+            Grow();
+        } else if (++stamp == 0) {
+            std::fill(slotStamps.begin(), slotStamps.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    /// <returns>False if the id was already in the set.</returns>
+    bool Insert(uint32_t id) {
+        if ((size + 1) * 2 > slotStamps.size())
+            Grow();
+        uint32_t slot = HomeSlot(id);
+        while (slotStamps[slot] == stamp) {
+            if (slotIds[slot] == id)
+                return false;
+            slot = (slot + 1) & slotMask;
+        }
+        slotStamps[slot] = stamp;
+        slotIds[slot] = id;
+        ++size;
+        return true;
+    }
+};
+
+// Scratch storage of a lookup: the candidate deletes, the ids of the suggestions already seen, the postings of
+// compressed buckets, the buffers of the batched distance verification and the suggestions found. Everything is
+// reused from one lookup to the next, so once the buffers have grown to the largest lookup so far a lookup
+// doesn't allocate, apart from the terms of suggestions too long for the short string buffer.
+// A context serves one lookup at a time; give every thread its own.
+class LookupContext {
+public:
+    LookupContext() = default;
+
+    DeleteEnumerator candidates;      // deletes of the input prefix, in the order they are generated
+    xstring candidate;                // the current candidate delete
+    xstring lowerInput;               // the input in lower case, when casing is transferred
+    IdSet seenSuggestions;
+    std::vector<uint32_t> postings;   // the decoded postings of the current bucket, when they are compressed
+    std::vector<std::pair<uint32_t, int>> screened;  // screened suggestions of a bucket and their distances
+    std::vector<xstring_view> unverifiedSuggestions; // suggestions of a bucket needing the edit distance
+    std::vector<int> distances;
+    PatternMasks inputMasks;
+    DistanceScratch distanceScratch;
+    std::vector<SuggestItem> suggestions; // the result of the last lookup
+    LookupStats stats;                    // work done by the last lookup
+};
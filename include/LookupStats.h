@@ -0,0 +1,61 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Work done by dictionary searches, cache hits are not searched and not counted.
+struct LookupStats {
+    uint64_t lookups = 0;
+    uint64_t signatureRejections = 0;  // suggestions the character signatures proved too far from the input
+    uint64_t distanceComputations = 0; // suggestions verified by computing their edit distance
+};
+
+// LookupStats summed over every thread. Copies take a snapshot of the counts.
+class LookupCounters {
+private:
+    std::atomic<uint64_t> lookups{0};
+    std::atomic<uint64_t> signatureRejections{0};
+    std::atomic<uint64_t> distanceComputations{0};
+
+    static void AddTo(std::atomic<uint64_t> &counter, uint64_t value) {
+        if (value != 0)
+            counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+public:
+    LookupCounters() = default;
+
+    LookupCounters(const LookupCounters &other) {
+        *this = other;
+    }
+
+    LookupCounters &operator=(const LookupCounters &other) {
+        LookupStats stats = other.Get();
+        lookups.store(stats.lookups, std::memory_order_relaxed);
+        signatureRejections.store(stats.signatureRejections, std::memory_order_relaxed);
+        distanceComputations.store(stats.distanceComputations, std::memory_order_relaxed);
+        return *this;
+    }
+
+    void Add(const LookupStats &stats) {
+        AddTo(lookups, stats.lookups);
+        AddTo(signatureRejections, stats.signatureRejections);
+        AddTo(distanceComputations, stats.distanceComputations);
+    }
+
+    LookupStats Get() const {
+        LookupStats stats;
+        stats.lookups = lookups.load(std::memory_order_relaxed);
+        stats.signatureRejections = signatureRejections.load(std::memory_order_relaxed);
+        stats.distanceComputations = distanceComputations.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void Reset() {
+        *this = LookupCounters();
+    }
+};
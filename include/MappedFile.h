@@ -0,0 +1,100 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file, unmapped when the object is destroyed.
+// The pages are shared with every other process mapping the same file through the page cache.
+class MappedFile {
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::invalid_argument("Unable to open file: " + path);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("Unable to read the size of file: " + path);
+        }
+        length = (size_t) fileSize.QuadPart;
+        if (length == 0)
+            return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+            bytes = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (bytes == nullptr) {
+            if (mapping != nullptr) CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Unable to map file: " + path);
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::invalid_argument("Unable to open file: " + path);
+        struct stat st{};
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Unable to read the size of file: " + path);
+        }
+        if (!S_ISREG(st.st_mode)) {
+            close(fd);
+            throw std::invalid_argument("Not a regular file: " + path);
+        }
+        length = (size_t) st.st_size;
+        if (length == 0) {
+            close(fd);
+            return;
+        }
+        void *address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+            throw std::runtime_error("Unable to map file: " + path);
+        bytes = (const char *) address;
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (bytes != nullptr) UnmapViewOfFile(bytes);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (bytes != nullptr) munmap((void *) bytes, length);
+#endif
+    }
+
+    const char *Data() const { return bytes; }
+
+    size_t Size() const { return length; }
+};
@@ -0,0 +1,64 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Defines.h"
+
+// Match bit-vectors of a pattern of at most 64 characters, as used by the bit-parallel distance kernels:
+// bit i of Get(c) is set when pattern[i] == c. Single byte characters index a table directly, wider characters
+// go through a small open-addressing table. Only the slots used by the previous pattern are cleared by Reset.
+class PatternMasks {
+public:
+    static constexpr int MaxLength = 64;
+
+private:
+    static constexpr bool DirectIndex = sizeof(xchar) == 1;
+    static constexpr uint32_t SlotCount = DirectIndex ? 256 : 128;  // at least twice the distinct characters
+
+    uint64_t masks[SlotCount] = {};
+    xchar keys[DirectIndex ? 1 : SlotCount] = {};
+    uint32_t usedSlots[MaxLength] = {};
+    int usedCount = 0;
+
+    static uint32_t HomeSlot(xchar c) {
+        if (DirectIndex)
+            return (uint32_t) (unsigned char) c;
+        return ((uint32_t) c * 2654435761u) >> 25;
+    }
+
+    uint32_t SlotOf(xchar c) const {
+        uint32_t slot = HomeSlot(c);
+        if (!DirectIndex) {
+            while (masks[slot] != 0 && keys[slot] != c) slot = (slot + 1) & (SlotCount - 1);
+        }
+        return slot;
+    }
+
+public:
+    PatternMasks() = default;
+
+    /// <summary>Compute the match vectors of a pattern, which must not be longer than MaxLength.</summary>
+    void Reset(xstring_view pattern) {
+        for (int i = 0; i < usedCount; ++i)
+            masks[usedSlots[i]] = 0;
+        usedCount = 0;
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            uint32_t slot = SlotOf(pattern[i]);
+            if (masks[slot] == 0) {
+                usedSlots[usedCount++] = slot;
+                if (!DirectIndex)
+                    keys[slot] = pattern[i];
+            }
+            masks[slot] |= uint64_t(1) << i;
+        }
+    }
+
+    uint64_t Get(xchar c) const {
+        return masks[SlotOf(c)];
+    }
+};
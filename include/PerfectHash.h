@@ -0,0 +1,213 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "FlatArray.h"
+#include "Snapshot.h"
+
+// Minimal perfect hash function over a fixed set of distinct 64 bit keys, built the PTHash way.
+// The keys are spread over buckets of about four keys, and every bucket gets a pilot value that sends all of its
+// keys to free positions of a table 2% larger than the key set. Buckets are placed largest first, while most
+// positions are still free, so the pilots stay small and fit 16 bits: about 4 bits per key. Positions past the
+// key count are remapped to the free positions below it, so the n keys map onto 0..n-1 exactly.
+// Keys outside the set map to an arbitrary position, callers verify what they find there.
+class PerfectHash {
+public:
+    /// <summary>The snapshot sections of a perfect hash function.</summary>
+    struct Sections {
+        SnapshotSectionId pilots, remap, parameters;
+    };
+
+private:
+    static constexpr uint32_t KeysPerBucket = 4;
+    static constexpr uint32_t MaxPilot = UINT16_MAX;
+    static constexpr int MaxAttempts = 16;
+
+    FlatArray<uint16_t> pilots;
+    FlatArray<uint32_t> remap;       // position - keyCount -> free position below keyCount
+    FlatArray<uint64_t> parameters;  // seed, keyCount, bucketCount, tableSize, as saved in snapshots
+    uint64_t seed = 0;
+    uint32_t keyCount = 0;
+    uint32_t bucketCount = 0;
+    uint32_t tableSize = 0;
+
+    static uint64_t Mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // maps the high 32 bits of a hash onto 0..n-1 without a division
+    static uint32_t Range(uint64_t hash, uint32_t n) {
+        return (uint32_t) (((hash >> 32) * n) >> 32);
+    }
+
+    uint32_t Position(uint64_t keyHash, uint32_t pilot) const {
+        return Range(Mix(keyHash ^ ((pilot + 1) * 0x9E3779B97F4A7C15ull)), tableSize);
+    }
+
+    void SetParameters(uint64_t newSeed, uint32_t keys, uint32_t buckets, uint32_t size) {
+        seed = newSeed;
+        keyCount = keys;
+        bucketCount = buckets;
+        tableSize = size;
+        parameters.clear();
+        for (uint64_t value : {seed, (uint64_t) keyCount, (uint64_t) bucketCount, (uint64_t) tableSize})
+            parameters.push_back(value);
+    }
+
+    bool TryBuild(const std::vector<uint64_t> &keys, uint64_t newSeed) {
+        const auto n = (uint32_t) keys.size();
+        SetParameters(newSeed, n, (n + KeysPerBucket - 1) / KeysPerBucket, n + n / 50 + 1);
+
+        // group the key hashes by bucket
+        std::vector<uint64_t> keyHashes(n);
+        std::vector<uint32_t> bucketStarts(bucketCount + 1, 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            keyHashes[i] = Mix(keys[i] ^ seed);
+            ++bucketStarts[Range(keyHashes[i], bucketCount) + 1];
+        }
+        for (uint32_t b = 0; b < bucketCount; ++b)
+            bucketStarts[b + 1] += bucketStarts[b];
+        std::vector<uint64_t> bucketKeys(n);
+        std::vector<uint32_t> fill(bucketStarts.begin(), bucketStarts.end() - 1);
+        for (uint32_t i = 0; i < n; ++i)
+            bucketKeys[fill[Range(keyHashes[i], bucketCount)]++] = keyHashes[i];
+
+        // largest buckets first, ties in bucket order so the result only depends on the keys
+        std::vector<uint32_t> order(bucketCount);
+        for (uint32_t b = 0; b < bucketCount; ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+            return bucketStarts[l + 1] - bucketStarts[l] > bucketStarts[r + 1] - bucketStarts[r];
+        });
+
+        std::vector<uint16_t> bucketPilots(bucketCount, 0);
+        std::vector<bool> taken(tableSize, false);
+        std::vector<uint32_t> positions;
+        for (uint32_t b : order) {
+            uint32_t first = bucketStarts[b], last = bucketStarts[b + 1];
+            if (first == last)
+                break;
+            bool placed = false;
+            for (uint32_t pilot = 0; pilot <= MaxPilot && !placed; ++pilot) {
+                positions.clear();
+                placed = true;
+                for (uint32_t k = first; k < last && placed; ++k) {
+                    uint32_t position = Position(bucketKeys[k], pilot);
+                    if (taken[position]) {
+                        placed = false;
+                    } else {
+                        taken[position] = true;
+                        positions.push_back(position);
+                    }
+                }
+                if (!placed) {
+                    for (uint32_t position : positions)
+                        taken[position] = false;
+                } else {
+                    bucketPilots[b] = (uint16_t) pilot;
+                }
+            }
+            if (!placed)
+                return false;
+        }
+
+        // the keys that landed past n move to the positions below n nobody took
+        std::vector<uint32_t> remapped(tableSize - n, 0);
+        uint32_t freePosition = 0;
+        for (uint32_t position = n; position < tableSize; ++position) {
+            if (!taken[position])
+                continue;
+            while (taken[freePosition]) ++freePosition;
+            remapped[position - n] = freePosition++;
+        }
+        pilots.clear();
+        pilots.append(bucketPilots.begin(), bucketPilots.end());
+        remap.clear();
+        remap.append(remapped.begin(), remapped.end());
+        return true;
+    }
+
+public:
+    PerfectHash() = default;
+
+    /// <summary>Build the function of a set of keys.</summary>
+    /// <returns>False if the keys aren't distinct, the function is left empty then.</returns>
+    bool Build(const std::vector<uint64_t> &keys) {
+        Clear();
+        if (keys.empty() || keys.size() >= UINT32_MAX / 2)
+            return false;
+        std::vector<uint64_t> sorted(keys);
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+            return false;
+        for (int attempt = 0; attempt < MaxAttempts; ++attempt) {
+            if (TryBuild(keys, Mix(0x5EED0000u + attempt)))
+                return true;
+        }
+        Clear();
+        return false;
+    }
+
+    void Clear() {
+        pilots.clear();
+        remap.clear();
+        parameters.clear();
+        seed = 0;
+        keyCount = bucketCount = tableSize = 0;
+    }
+
+    bool Empty() const { return keyCount == 0; }
+
+    /// <summary>The position of a key of the set, 0 to the key count - 1. The function must not be empty.</summary>
+    uint32_t Index(uint64_t key) const {
+        uint64_t keyHash = Mix(key ^ seed);
+        uint32_t position = Position(keyHash, pilots[Range(keyHash, bucketCount)]);
+        return position < keyCount ? position : remap[position - keyCount];
+    }
+
+    void WriteSections(SnapshotWriter &writer, const Sections &sections) const {
+        writer.Add(sections.pilots, pilots);
+        writer.Add(sections.remap, remap);
+        writer.Add(sections.parameters, parameters);
+    }
+
+    void ReadSections(const SnapshotReader &reader, const Sections &sections) {
+        reader.Borrow(sections.pilots, pilots);
+        reader.Borrow(sections.remap, remap);
+        reader.Borrow(sections.parameters, parameters);
+        if (parameters.empty()) {
+            seed = 0;
+            keyCount = bucketCount = tableSize = 0;
+            return;
+        }
+        if (parameters.size() != 4)
+            throw std::invalid_argument("Corrupt snapshot: inconsistent perfect hash sections");
+        seed = parameters[0];
+        keyCount = (uint32_t) parameters[1];
+        bucketCount = (uint32_t) parameters[2];
+        tableSize = (uint32_t) parameters[3];
+        if (keyCount == 0 || pilots.size() != bucketCount || tableSize < keyCount ||
+            remap.size() != tableSize - keyCount)
+            throw std::invalid_argument("Corrupt snapshot: inconsistent perfect hash sections");
+        for (uint32_t position : remap) {
+            if (position >= keyCount)
+                throw std::invalid_argument("Corrupt snapshot: inconsistent perfect hash sections");
+        }
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(pilots, remap, parameters, seed, keyCount, bucketCount, tableSize);
+    }
+};
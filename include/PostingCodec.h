@@ -0,0 +1,148 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#   include <tmmintrin.h>
+#   define POSTING_CODEC_SIMD 1
+#endif
+
+/// <summary>How the postings of a frozen delete index are stored.</summary>
+enum class PostingCodec : uint32_t {
+    /// <summary>4 bytes per word id, nothing to decode.</summary>
+    Raw = 0,
+    /// <summary>Gaps between consecutive ids in LEB128 varints, 7 bits per byte.</summary>
+    Varint = 1,
+    /// <summary>Gaps in 1 to 4 bytes each, the lengths of 4 gaps packed in a control byte ahead of them, which
+    /// lets SIMD decode 4 gaps per shuffle.</summary>
+    StreamVByte = 2
+};
+
+// Encoding and decoding of the ascending word ids of one delete bucket. An encoded bucket starts with its id
+// count as a varint, followed by the gaps between consecutive ids, the first gap is taken from 0.
+// Decoders may read up to Padding bytes past the end of the last bucket, so encoders leave them there.
+class PostingCoder {
+public:
+    static constexpr size_t Padding = 16;
+
+    static bool Valid(uint32_t codec) {
+        return codec <= (uint32_t) PostingCodec::StreamVByte;
+    }
+
+    static void Encode(PostingCodec codec, const uint32_t *ids, size_t count, std::vector<uint8_t> &out) {
+        PutVarint((uint32_t) count, out);
+        if (codec == PostingCodec::Varint) {
+            uint32_t previous = 0;
+            for (size_t i = 0; i < count; ++i) {
+                PutVarint(ids[i] - previous, out);
+                previous = ids[i];
+            }
+            return;
+        }
+        size_t controlStart = out.size();
+        out.resize(out.size() + (count + 3) / 4, 0);
+        uint32_t previous = 0;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t gap = ids[i] - previous;
+            previous = ids[i];
+            int bytes = gap < (1u << 8) ? 1 : gap < (1u << 16) ? 2 : gap < (1u << 24) ? 3 : 4;
+            out[controlStart + i / 4] |= (uint8_t) ((bytes - 1) << (2 * (i % 4)));
+            for (int b = 0; b < bytes; ++b)
+                out.push_back((uint8_t) (gap >> (8 * b)));
+        }
+    }
+
+    /// <summary>Decode the bucket in data[0, size) into ids.</summary>
+    static void Decode(PostingCodec codec, const uint8_t *data, size_t size, std::vector<uint32_t> &ids) {
+        const uint8_t *end = data + size;
+        // every id takes at least a byte, which bounds the count of a corrupt bucket
+        size_t count = std::min<size_t>(GetVarint(data, end), (size_t) (end - data));
+        ids.resize(count);
+        if (codec == PostingCodec::Varint) {
+            uint32_t previous = 0;
+            for (size_t i = 0; i < count; ++i) {
+                previous += GetVarint(data, end);
+                ids[i] = previous;
+            }
+            return;
+        }
+        const uint8_t *controls = data;
+        data += (count + 3) / 4;
+        uint32_t previous = 0;
+        size_t i = 0;
+#ifdef POSTING_CODEC_SIMD
+        const Tables &tables = GetTables();
+        for (; i + 4 <= count && data + 16 <= end + Padding; i += 4) {
+            uint8_t control = controls[i / 4];
+            __m128i gaps = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i *>(tables.shuffles[control])));
+            gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 4));
+            gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 8));
+            gaps = _mm_add_epi32(gaps, _mm_set1_epi32((int) previous));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(ids.data() + i), gaps);
+            previous = (uint32_t) _mm_cvtsi128_si32(_mm_shuffle_epi32(gaps, 0xFF));
+            data += tables.lengths[control];
+        }
+#endif
+        for (; i < count; ++i) {
+            int bytes = ((controls[i / 4] >> (2 * (i % 4))) & 3) + 1;
+            uint32_t gap = 0;
+            for (int b = 0; b < bytes && data < end; ++b)
+                gap |= (uint32_t) *data++ << (8 * b);
+            previous += gap;
+            ids[i] = previous;
+        }
+    }
+
+private:
+    static void PutVarint(uint32_t value, std::vector<uint8_t> &out) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t) (value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t) value);
+    }
+
+    static uint32_t GetVarint(const uint8_t *&data, const uint8_t *end) {
+        uint32_t value = 0;
+        for (int shift = 0; data < end && shift < 35; shift += 7) {
+            uint8_t byte = *data++;
+            value |= (uint32_t) (byte & 0x7F) << shift;
+            if (byte < 0x80)
+                break;
+        }
+        return value;
+    }
+
+#ifdef POSTING_CODEC_SIMD
+    // for every control byte, the shuffle spreading its 4 gaps over 4 lanes and the bytes they take
+    struct Tables {
+        alignas(16) uint8_t shuffles[256][16];
+        uint8_t lengths[256];
+
+        Tables() {
+            for (int control = 0; control < 256; ++control) {
+                int source = 0;
+                for (int lane = 0; lane < 4; ++lane) {
+                    int bytes = ((control >> (2 * lane)) & 3) + 1;
+                    for (int b = 0; b < 4; ++b)
+                        shuffles[control][lane * 4 + b] = b < bytes ? (uint8_t) source++ : 0x80;
+                }
+                lengths[control] = (uint8_t) source;
+            }
+        }
+    };
+
+    static const Tables &GetTables() {
+        static const Tables tables;
+        return tables;
+    }
+#endif
+};
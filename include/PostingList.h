@@ -0,0 +1,142 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// Word ids of one delete bucket in the mutable index. Most buckets hold a word or two, so up to InlineCapacity
+// ids are kept inside the object itself, in the room a std::vector would take for its three pointers, and only
+// larger buckets allocate. Saves and loads like the std::vector<uint32_t> bucket it replaced, so it adds no pickle
+// format of its own: the delete buckets of pickle formats 2 and later have this layout.
+class PostingList {
+public:
+    static constexpr uint32_t InlineCapacity = 4;
+
+private:
+    uint32_t count = 0;
+    uint32_t capacity = InlineCapacity;
+    union {
+        uint32_t inlineIds[InlineCapacity];
+        uint32_t *heapIds;
+    };
+
+    bool IsInline() const { return capacity == InlineCapacity; }
+
+    void Grow(uint32_t minimum) {
+        uint32_t newCapacity = std::max(minimum, capacity * 2);
+        auto *ids = new uint32_t[newCapacity];
+        std::copy(begin(), end(), ids);
+        Release();
+        heapIds = ids;
+        capacity = newCapacity;
+    }
+
+    void Release() {
+        if (!IsInline())
+            delete[] heapIds;
+        capacity = InlineCapacity;
+    }
+
+    void Take(PostingList &other) {
+        count = other.count;
+        if (other.IsInline()) {
+            std::copy(other.inlineIds, other.inlineIds + other.count, inlineIds);
+        } else {
+            heapIds = other.heapIds;
+            capacity = other.capacity;
+            other.capacity = InlineCapacity;
+        }
+        other.count = 0;
+    }
+
+public:
+    PostingList() {}
+
+    PostingList(const PostingList &other) {
+        append(other.begin(), other.end());
+    }
+
+    PostingList(PostingList &&other) noexcept {
+        Take(other);
+    }
+
+    PostingList &operator=(const PostingList &other) {
+        if (this != &other) {
+            clear();
+            append(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    PostingList &operator=(PostingList &&other) noexcept {
+        if (this != &other) {
+            Release();
+            Take(other);
+        }
+        return *this;
+    }
+
+    ~PostingList() { Release(); }
+
+    const uint32_t *data() const { return IsInline() ? inlineIds : heapIds; }
+
+    uint32_t *data() { return IsInline() ? inlineIds : heapIds; }
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    const uint32_t *begin() const { return data(); }
+
+    const uint32_t *end() const { return data() + count; }
+
+    uint32_t *begin() { return data(); }
+
+    uint32_t *end() { return data() + count; }
+
+    void reserve(size_t minimum) {
+        if (minimum > capacity)
+            Grow((uint32_t) minimum);
+    }
+
+    void push_back(uint32_t id) {
+        if (count == capacity)
+            Grow(count + 1);
+        data()[count++] = id;
+    }
+
+    template<class It>
+    void append(It first, It last) {
+        auto added = (size_t) std::distance(first, last);
+        reserve(count + added);
+        std::copy(first, last, end());
+        count += (uint32_t) added;
+    }
+
+    void erase(const uint32_t *position) {
+        uint32_t *ids = data();
+        std::copy(ids + (position - ids) + 1, ids + count, ids + (position - ids));
+        --count;
+    }
+
+    void clear() { count = 0; }
+
+    template<class Archive>
+    void save(Archive &ar) const {
+        ar(std::vector<uint32_t>(begin(), end()));
+    }
+
+    template<class Archive>
+    void load(Archive &ar) {
+        std::vector<uint32_t> ids;
+        ar(ids);
+        clear();
+        append(ids.begin(), ids.end());
+    }
+};
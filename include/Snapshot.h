@@ -0,0 +1,190 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Defines.h"
+#include "FlatArray.h"
+
+// Position-independent dictionary snapshot, laid out so it can be mapped read-only and used in place:
+//
+//   SnapshotHeader | SnapshotSection[sectionCount] | section data ...
+//
+// Every section is an array of plain values starting at a 64 byte aligned offset from the start of the file,
+// so no pointers are stored and a mapped snapshot needs no deserialization at all.
+enum class SnapshotSectionId : uint32_t {
+    TermChars = 1,
+    TermOffsets = 2,
+    TermHashes = 3,
+    TermSlots = 4,
+    WordCounts = 5,
+    DeleteBucketHashes = 6,
+    DeleteBucketOffsets = 7,
+    DeletePostings = 8,
+    WordInfos = 9,
+    BigramChars = 10,
+    BigramOffsets = 11,
+    BigramHashes = 12,
+    BigramSlots = 13,
+    BigramCounts = 14,
+    TermPerfectSlots = 15,
+    TermPilots = 16,
+    TermRemap = 17,
+    TermHashParameters = 18,
+    BigramPerfectSlots = 19,
+    BigramPilots = 20,
+    BigramRemap = 21,
+    BigramHashParameters = 22,
+    DeletePilots = 23,
+    DeleteRemap = 24,
+    DeleteHashParameters = 25,
+    DeleteEncodedPostings = 26,
+    WordLengthStarts = 27
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;     // written as 0x01020304, a snapshot from a machine with other endianness is rejected
+    uint32_t charSize;      // sizeof(xchar) of the writer, unicode and ascii builds can't share snapshots
+    uint32_t sectionCount;
+    int32_t maxDictionaryEditDistance;
+    int32_t prefixLength;
+    int32_t compactMask;
+    int32_t maxDictionaryWordLength;
+    uint32_t postingCodec;
+    uint32_t reserved;      // keeps the 64 bit fields aligned, written as 0
+    int64_t countThreshold;
+    int64_t wordCount;
+    int64_t entryCount;
+    int64_t bigramCountMin;
+};
+
+struct SnapshotSection {
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t count;
+};
+
+static const char SnapshotMagic[8] = {'S', 'Y', 'M', 'S', 'N', 'A', 'P', '\0'};
+// 2: the postings of a delete bucket are sorted by word length, 3: word signatures, 4: bigrams,
+// 5: terms and delete buckets are found by perfect hashes, 6: compressed postings, 7: word infos and
+// length starts replace signatures
+static const uint32_t SnapshotVersion = 7;
+static const uint32_t SnapshotByteOrder = 0x01020304;
+static const uint64_t SnapshotAlignment = 64;
+
+class SnapshotWriter {
+private:
+    struct PendingSection {
+        SnapshotSection section;
+        const char *data;
+    };
+    std::vector<PendingSection> sections;
+
+    static uint64_t Align(uint64_t offset) {
+        return (offset + SnapshotAlignment - 1) / SnapshotAlignment * SnapshotAlignment;
+    }
+
+public:
+    /// <summary>Queue an array for writing, the array must stay alive until Write is called.</summary>
+    template<class T>
+    void Add(SnapshotSectionId id, const FlatArray<T> &values) {
+        PendingSection pending{};
+        pending.section.id = (uint32_t) id;
+        pending.section.elementSize = sizeof(T);
+        pending.section.count = values.size();
+        pending.data = reinterpret_cast<const char *>(values.data());
+        sections.push_back(pending);
+    }
+
+    void Write(std::ostream &out, SnapshotHeader header) {
+        std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+        header.version = SnapshotVersion;
+        header.byteOrder = SnapshotByteOrder;
+        header.sectionCount = (uint32_t) sections.size();
+
+        uint64_t offset = Align(sizeof(SnapshotHeader) + sections.size() * sizeof(SnapshotSection));
+        for (auto &pending : sections) {
+            pending.section.offset = offset;
+            offset = Align(offset + pending.section.count * pending.section.elementSize);
+        }
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (const auto &pending : sections)
+            out.write(reinterpret_cast<const char *>(&pending.section), sizeof(SnapshotSection));
+        uint64_t position = sizeof(SnapshotHeader) + sections.size() * sizeof(SnapshotSection);
+        const char padding[SnapshotAlignment] = {};
+        for (const auto &pending : sections) {
+            out.write(padding, (std::streamsize) (pending.section.offset - position));
+            uint64_t bytes = pending.section.count * pending.section.elementSize;
+            out.write(pending.data, (std::streamsize) bytes);
+            position = pending.section.offset + bytes;
+        }
+        out.write(padding, (std::streamsize) (Align(position) - position));
+        if (!out)
+            throw std::runtime_error("Unable to write snapshot");
+    }
+};
+
+class SnapshotReader {
+private:
+    const char *bytes;
+    size_t length;
+    SnapshotHeader header{};
+
+    const SnapshotSection *Find(SnapshotSectionId id) const {
+        auto table = reinterpret_cast<const SnapshotSection *>(bytes + sizeof(SnapshotHeader));
+        for (uint32_t i = 0; i < header.sectionCount; ++i) {
+            if (table[i].id == (uint32_t) id)
+                return &table[i];
+        }
+        return nullptr;
+    }
+
+public:
+    /// <summary>Validate the header and section table of a mapped snapshot.</summary>
+    SnapshotReader(const char *data, size_t size) : bytes(data), length(size) {
+        if (bytes == nullptr || length < sizeof(SnapshotHeader))
+            throw std::invalid_argument("Not a SymSpell snapshot: file is too small");
+        std::memcpy(&header, bytes, sizeof(SnapshotHeader));
+        if (std::memcmp(header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+            throw std::invalid_argument("Not a SymSpell snapshot: bad magic");
+        if (header.version != SnapshotVersion)
+            throw std::invalid_argument("Unsupported snapshot version " + std::to_string(header.version));
+        if (header.byteOrder != SnapshotByteOrder)
+            throw std::invalid_argument("Snapshot was written on a machine with different byte order");
+        if (header.charSize != sizeof(xchar))
+            throw std::invalid_argument("Snapshot was written with a different character type");
+        if (sizeof(SnapshotHeader) + (uint64_t) header.sectionCount * sizeof(SnapshotSection) > length)
+            throw std::invalid_argument("Corrupt snapshot: truncated section table");
+        auto table = reinterpret_cast<const SnapshotSection *>(bytes + sizeof(SnapshotHeader));
+        for (uint32_t i = 0; i < header.sectionCount; ++i) {
+            const SnapshotSection &section = table[i];
+            if (section.offset % SnapshotAlignment != 0 || section.offset > length ||
+                section.elementSize == 0 || section.count > (length - section.offset) / section.elementSize)
+                throw std::invalid_argument("Corrupt snapshot: section out of bounds");
+        }
+    }
+
+    const SnapshotHeader &Header() const { return header; }
+
+    /// <summary>Point an array at a section of the snapshot without copying it.</summary>
+    template<class T>
+    void Borrow(SnapshotSectionId id, FlatArray<T> &values) const {
+        const SnapshotSection *section = Find(id);
+        if (section == nullptr)
+            throw std::invalid_argument("Corrupt snapshot: missing section " + std::to_string((uint32_t) id));
+        if (section->elementSize != sizeof(T))
+            throw std::invalid_argument("Corrupt snapshot: unexpected element size in section " + std::to_string((uint32_t) id));
+        values.Borrow(reinterpret_cast<const T *>(bytes + section->offset), section->count);
+    }
+};
@@ -0,0 +1,204 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "Defines.h"
+#include "FlatArray.h"
+#include "PerfectHash.h"
+#include "Snapshot.h"
+
+// Interned storage for dictionary terms.
+// All term characters live in one contiguous buffer, term i spans chars[offsets[i], offsets[i + 1]).
+// Terms are addressed by a dense 32-bit id, an open-addressing table over the ids maps a term back to its id.
+// Once frozen the table is replaced by a minimal perfect hash of the terms' 64 bit hashes, which maps a term to
+// exactly one slot holding an id and the upper half of that hash: an absent term is almost always rejected by
+// this fingerprint, without touching the term characters.
+class TermArena {
+private:
+    FlatArray<xchar> chars;
+    FlatArray<uint32_t> offsets{0};
+    FlatArray<uint32_t> hashes;
+    FlatArray<uint32_t> slots;
+    uint32_t slotMask = 0;
+    PerfectHash perfectHash;
+    FlatArray<uint64_t> perfectSlots;  // fingerprint << 32 | id, by perfect hash position
+
+    // FNV-1a, the hashes are persisted in snapshots so they must not depend on the standard library
+    static uint32_t HashOf(xstring_view term) {
+        uint32_t hash = 2166136261u;
+        for (xchar c : term) {
+            hash ^= (uint32_t) c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static uint64_t Hash64Of(xstring_view term) {
+        uint64_t hash = 14695981039346656037ull;
+        for (xchar c : term) {
+            hash ^= (uint64_t) c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void Rehash(uint32_t capacity) {
+        slots.assign(capacity, npos);
+        slotMask = capacity - 1;
+        for (uint32_t id = 0; id < hashes.size(); ++id) {
+            uint32_t slot = hashes[id] & slotMask;
+            while (slots[slot] != npos) slot = (slot + 1) & slotMask;
+            slots.Set(slot, id);
+        }
+    }
+
+    uint32_t FindSlot(xstring_view term, uint32_t hash) const {
+        uint32_t slot = hash & slotMask;
+        while (slots[slot] != npos) {
+            uint32_t id = slots[slot];
+            if (hashes[id] == hash && View(id) == term)
+                break;
+            slot = (slot + 1) & slotMask;
+        }
+        return slot;
+    }
+
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    /// <summary>The snapshot sections of an arena, a snapshot can hold several arenas.</summary>
+    struct Sections {
+        SnapshotSectionId chars, offsets, hashes, slots, perfectSlots;
+        PerfectHash::Sections perfectHash;
+    };
+
+    static constexpr Sections WordSections{
+            SnapshotSectionId::TermChars, SnapshotSectionId::TermOffsets, SnapshotSectionId::TermHashes,
+            SnapshotSectionId::TermSlots, SnapshotSectionId::TermPerfectSlots,
+            {SnapshotSectionId::TermPilots, SnapshotSectionId::TermRemap, SnapshotSectionId::TermHashParameters}};
+    static constexpr Sections BigramSections{
+            SnapshotSectionId::BigramChars, SnapshotSectionId::BigramOffsets, SnapshotSectionId::BigramHashes,
+            SnapshotSectionId::BigramSlots, SnapshotSectionId::BigramPerfectSlots,
+            {SnapshotSectionId::BigramPilots, SnapshotSectionId::BigramRemap, SnapshotSectionId::BigramHashParameters}};
+
+    TermArena() = default;
+
+    void Reserve(uint32_t termCount) {
+        if (Frozen())
+            return;
+        offsets.reserve(termCount + 1);
+        hashes.reserve(termCount);
+        uint32_t capacity = 16;
+        while (capacity < termCount * 2) capacity <<= 1u;
+        if (capacity > slots.size())
+            Rehash(capacity);
+    }
+
+    uint32_t Size() const { return (uint32_t) hashes.size(); }
+
+    xstring_view View(uint32_t id) const {
+        return xstring_view(chars.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    int Length(uint32_t id) const { return (int) (offsets[id + 1] - offsets[id]); }
+
+    /// <summary>Find the id of a term.</summary>
+    /// <returns>The term id, or npos if the term was never interned.</returns>
+    uint32_t Find(xstring_view term) const {
+        if (!perfectSlots.empty()) {
+            uint64_t hash = Hash64Of(term);
+            uint64_t slot = perfectSlots[perfectHash.Index(hash)];
+            if ((slot >> 32) != (hash >> 32))
+                return npos;
+            auto id = (uint32_t) slot;
+            return View(id) == term ? id : npos;
+        }
+        if (slots.empty())
+            return npos;
+        return slots[FindSlot(term, HashOf(term))];
+    }
+
+    bool Frozen() const { return !perfectSlots.empty(); }
+
+    /// <summary>Replace the open-addressing table by a perfect hash, no term can be interned anymore.
+    /// Keeps the table if two terms share their 64 bit hash.</summary>
+    void Freeze() {
+        if (Frozen() || Size() == 0)
+            return;
+        std::vector<uint64_t> keys(Size());
+        for (uint32_t id = 0; id < Size(); ++id)
+            keys[id] = Hash64Of(View(id));
+        if (!perfectHash.Build(keys))
+            return;
+        std::vector<uint64_t> built(Size());
+        for (uint32_t id = 0; id < Size(); ++id)
+            built[perfectHash.Index(keys[id])] = (keys[id] >> 32) << 32 | id;
+        perfectSlots.clear();
+        perfectSlots.append(built.begin(), built.end());
+        slots.clear();
+        slotMask = 0;
+    }
+
+    /// <summary>Find the id of a term, adding the term to the arena if it isn't there yet.</summary>
+    uint32_t Intern(xstring_view term) {
+        if (Frozen())
+            throw std::logic_error("Term arena is frozen");
+        if (slots.empty())
+            Rehash(16);
+        uint32_t hash = HashOf(term);
+        uint32_t slot = FindSlot(term, hash);
+        if (slots[slot] != npos)
+            return slots[slot];
+        if (chars.size() + term.size() > UINT32_MAX)
+            throw std::length_error("Term arena is full");
+
+        auto id = (uint32_t) hashes.size();
+        chars.append(term.begin(), term.end());
+        offsets.push_back((uint32_t) chars.size());
+        hashes.push_back(hash);
+        if (hashes.size() * 2 > slots.size())
+            Rehash((uint32_t) slots.size() * 2);
+        else
+            slots.Set(slot, id);
+        return id;
+    }
+
+    void WriteSections(SnapshotWriter &writer, const Sections &sections = WordSections) const {
+        writer.Add(sections.chars, chars);
+        writer.Add(sections.offsets, offsets);
+        writer.Add(sections.hashes, hashes);
+        writer.Add(sections.slots, slots);
+        writer.Add(sections.perfectSlots, perfectSlots);
+        perfectHash.WriteSections(writer, sections.perfectHash);
+    }
+
+    void ReadSections(const SnapshotReader &reader, const Sections &sections = WordSections) {
+        reader.Borrow(sections.chars, chars);
+        reader.Borrow(sections.offsets, offsets);
+        reader.Borrow(sections.hashes, hashes);
+        reader.Borrow(sections.slots, slots);
+        reader.Borrow(sections.perfectSlots, perfectSlots);
+        perfectHash.ReadSections(reader, sections.perfectHash);
+        if (offsets.size() != hashes.size() + 1 || (!slots.empty() && (slots.size() & (slots.size() - 1)) != 0))
+            throw std::invalid_argument("Corrupt snapshot: inconsistent term sections");
+        if (!perfectSlots.empty() && (perfectSlots.size() != hashes.size() || perfectHash.Empty() || !slots.empty()))
+            throw std::invalid_argument("Corrupt snapshot: inconsistent term sections");
+        for (uint64_t slot : perfectSlots) {
+            if ((uint32_t) slot >= hashes.size())
+                throw std::invalid_argument("Corrupt snapshot: inconsistent term sections");
+        }
+        slotMask = slots.empty() ? 0 : (uint32_t) slots.size() - 1;
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(chars, offsets, hashes, slots, slotMask, perfectHash, perfectSlots);
+    }
+};
@@ -0,0 +1,44 @@
+//
+// Created by vigi99 on 18/10/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include "CharSignature.h"
+#include "Defines.h"
+
+// What the lookup loop needs to know of a suggestion before reading its characters, packed in 16 bytes and
+// indexed by word id: a suggestion's term is only read once its lengths, count and signature let it through.
+struct WordInfo {
+    static constexpr uint32_t MaxLength = (1u << 24) - 1;
+
+    uint64_t signature = 0;  // CharSignature of the word
+    uint32_t count = 0;      // the count saturated to 32 bits, 0 once the word has been deleted
+    uint32_t lengths = 0;    // length << 8 | length of the prefix the deletes are generated from
+
+    static WordInfo Of(xstring_view word, int64_t wordCount, int prefixLength) {
+        WordInfo info;
+        info.signature = CharSignature::Of(word);
+        info.lengths = (uint32_t) word.size() << 8 | (uint32_t) std::min((int) word.size(), prefixLength);
+        info.SetCount(wordCount);
+        return info;
+    }
+
+    int Length() const { return (int) (lengths >> 8); }
+
+    int PrefixLength() const { return (int) (lengths & 0xFF); }
+
+    /// <summary>An upper bound of the count, the count itself unless it was saturated.</summary>
+    int64_t CountBound() const { return count == UINT32_MAX ? INT64_MAX : count; }
+
+    void SetCount(int64_t wordCount) {
+        count = (uint32_t) std::min<int64_t>(std::max<int64_t>(wordCount, 0), UINT32_MAX);
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(signature, count, lengths);
+    }
+};
@@ -1,11 +1,19 @@
 #include "library.h"
 
+#include <atomic>
 #include <codecvt>
+#include <iterator>
 #include <utility>
 #include <fstream>
 
 namespace symspellcpppy
 {
+    // scratch storage of the lookups that don't get a context from their caller
+    static LookupContext &ThreadLookupContext()
+    {
+        static thread_local LookupContext context;
+        return context;
+    }
 
     int SymSpell::MaxDictionaryEditDistance() const
     {
@@ -27,21 +35,46 @@ namespace symspellcpppy
         return countThreshold;
     }
 
-    int SymSpell::WordCount()
+    int SymSpell::WordCount() const
     {
-        return words.size();
+        return wordCount;
     }
 
-    int SymSpell::EntryCount()
+    int SymSpell::EntryCount() const
     {
+        if (frozen)
+            return frozenIndex.EntryCount();
         return deletes == nullptr ? 0 : deletes->size();
     }
 
+    bool SymSpell::IsFrozen() const
+    {
+        return frozen;
+    }
+
+    PostingCodec SymSpell::GetPostingCodec() const
+    {
+        return frozen ? frozenIndex.Codec() : postingCodec;
+    }
+
+    PostingCodec SymSpell::PostingCodecOf(int compactLevel)
+    {
+        if (compactLevel <= DEFAULT_COMPACT_LEVEL)
+            return PostingCodec::Raw;
+        return compactLevel <= 10 ? PostingCodec::StreamVByte : PostingCodec::Varint;
+    }
+
+    DistanceAlgorithm SymSpell::GetDistanceAlgorithm() const
+    {
+        return distanceAlgorithm;
+    }
+
     SymSpell::SymSpell(int _maxDictionaryEditDistance, int _prefixLength, int _countThreshold, int _initialCapacity,
-                       unsigned char _compactLevel) : maxDictionaryEditDistance(_maxDictionaryEditDistance),
-                                                      prefixLength(_prefixLength),
-                                                      countThreshold(_countThreshold),
-                                                      initialCapacity(_initialCapacity)
+                       unsigned char _compactLevel, DistanceAlgorithm _distanceAlgorithm) : maxDictionaryEditDistance(_maxDictionaryEditDistance),
+                                                                                             prefixLength(_prefixLength),
+                                                                                             countThreshold(_countThreshold),
+                                                                                             initialCapacity(_initialCapacity),
+                                                                                             distanceAlgorithm(_distanceAlgorithm)
     {
         if (_initialCapacity < 0)
             throw std::invalid_argument("initial_capacity is too small.");
@@ -50,245 +83,352 @@ namespace symspellcpppy
         if (_prefixLength < 1 || _prefixLength <= _maxDictionaryEditDistance)
             throw std::invalid_argument(
                 "prefix_length cannot be less than 1 or smaller than max_dictionary_edit_distance");
+        if (_prefixLength > DeleteEnumerator::MaxWordLength)
+            throw std::invalid_argument("prefix_length cannot be greater than 64");
         if (_countThreshold < 0)
             throw std::invalid_argument("count_threshold cannot be negative");
         if (_compactLevel > 16)
             throw std::invalid_argument("compact_level cannot be greater than 16");
+        if (_distanceAlgorithm != DistanceAlgorithm::DamerauOSADistance &&
+            _distanceAlgorithm != DistanceAlgorithm::LevenshteinDistance)
+            throw std::invalid_argument("Unknown distance algorithm.");
 
         if (_compactLevel > 16)
             _compactLevel = 16;
         compactMask = (UINT_MAX >> (3 + _compactLevel)) << 2;
+        postingCodec = PostingCodecOf(_compactLevel);
         maxDictionaryWordLength = 0;
-        words = std::unordered_map<xstring, int64_t>(initialCapacity);
+        terms.Reserve(initialCapacity);
+        wordCounts.reserve(initialCapacity);
+        wordInfos.reserve(initialCapacity);
     }
 
     bool SymSpell::CreateDictionaryEntry(const xstring &key, int64_t count,
                                          const std::shared_ptr<SuggestionStage> &staging)
     {
+        uint32_t wordId = CountDictionaryEntry(key, count);
+        if (wordId == TermArena::npos)
+            return false;
+
+        // create deletes
+        static thread_local DeleteEnumerator edits;
+        EditsPrefix(key, edits);
+        if (staging != nullptr)
+        {
+            for (size_t i = 0; i < edits.Size(); i++)
+            {
+                staging->Add(GetstringHash(edits[i]), wordId);
+            }
+        }
+        else
+        {
+            if (deletes == nullptr)
+                deletes = std::make_shared<std::unordered_map<int, PostingList>>();
+            for (size_t i = 0; i < edits.Size(); i++)
+            {
+                (*deletes)[GetstringHash(edits[i])].push_back(wordId);
+            }
+        }
+
+        return true;
+    }
+
+    uint32_t SymSpell::CountDictionaryEntry(xstring_view key, int64_t count)
+    {
+        if (frozen)
+            throw std::logic_error("Cannot add entries to a frozen dictionary");
+        ClearLookupCache();
 
         if (count <= 0)
         {
             if (countThreshold > 0)
-                return false; // no point doing anything if count is zero, as it can't change anything
+                return TermArena::npos; // no point doing anything if count is zero, as it can't change anything
             count = 0;
         }
-        int countPrevious = -1;
-        auto belowThresholdWordsFinded = belowThresholdWords.find(key);
-        auto wordsFinded = words.find(key);
-        if (countThreshold > 1 && belowThresholdWordsFinded != belowThresholdWords.end())
+        int64_t countPrevious = -1;
+        // words are only ever held below the threshold when it is above 1
+        auto belowThresholdWordsFinded = belowThresholdWords.end();
+        if (countThreshold > 1)
+            belowThresholdWordsFinded = belowThresholdWords.find(xstring(key));
+        uint32_t wordId = terms.Find(key);
+        if (belowThresholdWordsFinded != belowThresholdWords.end())
         {
             countPrevious = belowThresholdWordsFinded->second;
             count = (MAXINT - countPrevious > count) ? countPrevious + count : MAXINT;
             if (count >= countThreshold)
             {
-                belowThresholdWords.erase(key);
+                belowThresholdWords.erase(belowThresholdWordsFinded);
             }
             else
             {
-                belowThresholdWords[key] = count;
-                return false;
+                belowThresholdWordsFinded->second = count;
+                return TermArena::npos;
             }
         }
-        else if (wordsFinded != words.end())
+        else if (wordId != TermArena::npos && wordCounts[wordId] >= 0)
         {
-            countPrevious = wordsFinded->second;
+            countPrevious = wordCounts[wordId];
             count = (MAXINT - countPrevious > count) ? countPrevious + count : MAXINT;
-            words.at(key) = count;
-            return false;
+            SetWordCount(wordId, count);
+            return TermArena::npos;
         }
         else if (count < CountThreshold())
         {
-            belowThresholdWords[key] = count;
-            return false;
+            belowThresholdWords[xstring(key)] = count;
+            return TermArena::npos;
         }
 
-        words.insert(std::pair<xstring, int64_t>(key, count));
-
-        if (key.size() > maxDictionaryWordLength)
-            maxDictionaryWordLength = key.size();
-
-        // create deletes
-        auto edits = EditsPrefix(key);
-        if (staging != nullptr)
+        // a deleted word keeps its id and is revived here
+        if (wordId == TermArena::npos)
         {
-            for (const auto &edit : *edits)
-            {
-                staging->Add(GetstringHash(edit), key);
-            }
+            if (key.size() > WordInfo::MaxLength)
+                throw std::length_error("Dictionary words cannot be longer than 16777215 characters");
+            wordId = terms.Intern(key);
+            wordCounts.push_back(count);
+            wordInfos.push_back(WordInfo::Of(key, count, prefixLength));
         }
         else
         {
-
-            for (const auto &edit : *edits)
-            {
-                int deleteHash = GetstringHash(edit);
-                auto deletesFinded = deletes->find(deleteHash);
-                std::vector<xstring> suggestions;
-                if (deletesFinded != deletes->end())
-                {
-                    suggestions = deletesFinded->second;
-                    std::vector<xstring> newSuggestions;
-                    newSuggestions.reserve(suggestions.size() + 1);
-                    std::copy(suggestions.begin(), suggestions.end(), std::back_inserter(newSuggestions));
-                    deletes->at(deleteHash) = suggestions = newSuggestions;
-                }
-                else
-                {
-                    suggestions = std::vector<xstring>(1);
-                    deletes->insert(std::pair<int, std::vector<xstring>>(deleteHash, suggestions));
-                }
-                suggestions[suggestions.size() - 1] = key;
-            }
+            SetWordCount(wordId, count);
         }
+        wordCount++;
 
-        return true;
+        if (key.size() > maxDictionaryWordLength)
+            maxDictionaryWordLength = key.size();
+
+        return wordId;
+    }
+
+    void SymSpell::SetWordCount(uint32_t wordId, int64_t count)
+    {
+        wordCounts.Set(wordId, count);
+        WordInfo info = wordInfos[wordId];
+        info.SetCount(count);
+        wordInfos.Set(wordId, info);
+    }
+
+    void SymSpell::CheckPickleVersion(uint32_t version)
+    {
+        // what every format changed, indexed by format
+        static const char *const formatChanges[PickleVersion + 1] = {
+            "",
+            "the frozen index follows the delete index",
+            "word ids and a term arena replace the words map",
+            "the letter signatures of the words are saved",
+            "packed word infos and the first id of every length replace the signatures",
+            "the bigrams are saved, frozen or not"};
+        if (version == PickleVersion)
+            return;
+        if (version != 0 && version < PickleVersion)
+            throw std::invalid_argument("Pickle format " + std::to_string(version) + " is no longer supported: in format " +
+                                        std::to_string(version + 1) + " " + formatChanges[version + 1] +
+                                        ". Rebuild the pickle from the dictionary");
+        // pickles written before the format was versioned start with the delete index instead of a version
+        throw std::invalid_argument("Unsupported pickle format: pickles written before the format was versioned or by a newer "
+                                    "release must be rebuilt from the dictionary (current format " + std::to_string(PickleVersion) +
+                                    ": " + formatChanges[PickleVersion] + ")");
+    }
+
+    uint32_t SymSpell::FirstIdOfLength(int length) const
+    {
+        if (length <= 0)
+            return 0;
+        return length < (int)wordLengthStarts.size() ? wordLengthStarts[length] : terms.Size();
     }
 
     bool SymSpell::DeleteDictionaryEntry(const xstring &key)
     {
-        auto wordsFinded = words.find(key);
-        if (wordsFinded != words.end())
+        if (frozen)
+            throw std::logic_error("Cannot delete entries from a frozen dictionary");
+        uint32_t wordId = terms.Find(key);
+        if (wordId == TermArena::npos || wordCounts[wordId] < 0)
+            return false;
+
+        ClearLookupCache();
+        SetWordCount(wordId, -1);
+        wordCount--;
+        if (key.size() == maxDictionaryWordLength)
         {
-            words.erase(wordsFinded);
-            if (wordsFinded->first.size() == maxDictionaryWordLength)
+            int max_size = 0;
+            for (uint32_t id = 0; id < terms.Size(); id++)
             {
-                int max_size = 0;
-                for (auto &word : words)
-                {
-                    max_size = std::max(static_cast<int>(word.first.size()), max_size);
-                }
-                maxDictionaryWordLength = max_size;
+                if (wordCounts[id] >= 0)
+                    max_size = std::max(terms.Length(id), max_size);
             }
-            auto edits = EditsPrefix(key);
-            for (const auto &edit : *edits)
+            maxDictionaryWordLength = max_size;
+        }
+        if (deletes != nullptr)
+        {
+            static thread_local DeleteEnumerator edits;
+            EditsPrefix(key, edits);
+            for (size_t i = 0; i < edits.Size(); i++)
             {
-                int deleteHash = GetstringHash(edit);
-                auto deletesFinded = deletes->find(deleteHash);
+                auto deletesFinded = deletes->find(GetstringHash(edits[i]));
                 if (deletesFinded != deletes->end())
                 {
-                    auto delete_vec = deletesFinded->second;
-                    auto it = std::find(delete_vec.begin(), delete_vec.end(), key);
-                    if (it < delete_vec.end())
+                    auto &delete_vec = deletesFinded->second;
+                    auto it = std::find(delete_vec.begin(), delete_vec.end(), wordId);
+                    if (it != delete_vec.end())
                         delete_vec.erase(it);
+                    if (delete_vec.empty())
+                        deletes->erase(deletesFinded);
                 }
             }
-            return true;
         }
-        return false;
+        return true;
     }
 
     bool
     SymSpell::LoadBigramDictionary(const std::string &corpus, int termIndex, int countIndex, xchar separatorChars)
     {
+#ifndef UNICODE_SUPPORT
+        std::unique_ptr<MappedFile> file;
+        try
+        {
+            file = std::make_unique<MappedFile>(corpus);
+        }
+        catch (const std::invalid_argument &)
+        {
+            return false;
+        }
+        std::vector<xstring_view> columns;
+        DictionaryParser::ForEachLine(file->Data(), file->Size(), [&](xstring_view line)
+                                      { LoadBigramDictionaryLine(line, termIndex, countIndex, separatorChars, columns); });
+        return !bigrams.empty();
+#else
         xifstream corpusStream;
         corpusStream.open(corpus);
-#ifdef UNICODE_SUPPORT
         std::locale utf8(std::locale(), new std::codecvt_utf8<wchar_t>);
         corpusStream.imbue(utf8);
-#endif
         if (!corpusStream.is_open())
             return false;
 
         return LoadBigramDictionary(corpusStream, termIndex, countIndex, separatorChars);
+#endif
     }
 
     bool SymSpell::LoadBigramDictionary(xifstream &corpusStream, int termIndex, int countIndex, xchar separatorChars)
     {
         xstring line;
-        int linePartsLength = (separatorChars == DEFAULT_SEPARATOR_CHAR) ? 3 : 2;
+        std::vector<xstring_view> columns;
         while (getline(corpusStream, line))
+            LoadBigramDictionaryLine(line, termIndex, countIndex, separatorChars, columns);
+
+        if (bigrams.empty())
+            return false;
+        return true;
+    }
+
+    void SymSpell::LoadBigramDictionaryLine(xstring_view line, int termIndex, int countIndex, xchar separatorChars,
+                                            std::vector<xstring_view> &columns)
+    {
+        DictionaryParser::SplitColumns(line, separatorChars, columns);
+        auto column = [&columns](int index)
+        { return index < columns.size() ? columns[index] : xstring_view(); };
+        int linePartsLength = (separatorChars == DEFAULT_SEPARATOR_CHAR) ? 3 : 2;
+        xstring key;
+        int64_t count = 1;
+        if (columns.size() >= linePartsLength)
         {
-            std::vector<xstring> lineParts;
-            xstringstream ss(line);
-            xstring token;
-            while (getline(ss, token, separatorChars))
-                lineParts.push_back(token);
-            xstring key;
-            int64_t count;
-            if (lineParts.size() >= linePartsLength)
+            key = column(termIndex);
+            if (separatorChars == DEFAULT_SEPARATOR_CHAR)
             {
-                key = (separatorChars == DEFAULT_SEPARATOR_CHAR) ? lineParts[termIndex] + XL(" ") +
-                                                                       lineParts[termIndex + 1]
-                                                                 : lineParts[termIndex];
-                try
-                {
-                    count = stoll(lineParts[countIndex]);
-                }
-                catch (...)
-                {
-                    printf("Cannot convert %s to integer\n", lineParts[countIndex].c_str());
-                }
+                key += XL(" ");
+                key += column(termIndex + 1);
             }
-            else
+            bool parsed = false;
+            try
             {
-                key = line;
-                count = 1;
+                parsed = DictionaryParser::ParseCount(column(countIndex), count);
+            }
+            catch (const std::out_of_range &)
+            {
+            }
+            if (!parsed)
+            {
+                printf("Cannot convert %s to integer\n", xstring(column(countIndex)).c_str());
+                return;
             }
-            std::pair<xstring, int64_t> element(key, count);
-            bigrams.insert(element);
-            if (count < bigramCountMin)
-                bigramCountMin = count;
         }
-
-        if (bigrams.empty())
-            return false;
-        return true;
+        else
+        {
+            key = line;
+        }
+        bigrams.emplace(std::move(key), count);
+        if (count < bigramCountMin)
+            bigramCountMin = count;
     }
 
-    bool SymSpell::LoadDictionary(const std::string &corpus, int termIndex, int countIndex, xchar separatorChars)
+    bool SymSpell::LoadDictionary(const std::string &corpus, int termIndex, int countIndex, xchar separatorChars,
+                                  int threads)
     {
-
+#ifndef UNICODE_SUPPORT
+        // the file is mapped and parsed in place, terms go straight from the mapping into the dictionary
+        std::unique_ptr<MappedFile> file;
+        try
+        {
+            file = std::make_unique<MappedFile>(corpus);
+        }
+        catch (const std::invalid_argument &)
+        {
+            return false;
+        }
+        threads = Helpers::ResolveThreadCount(threads);
+        std::vector<uint32_t> wordIds;
+        std::vector<xstring_view> columns;
+        DictionaryParser::ForEachLine(file->Data(), file->Size(), [&](xstring_view line)
+                                      { LoadDictionaryLine(line, termIndex, countIndex, separatorChars, columns, wordIds); });
+        CommitDeletes(wordIds, threads);
+        return EntryCount() != 0;
+#else
         xifstream corpusStream(corpus);
-#ifdef UNICODE_SUPPORT
         std::locale utf8(std::locale(), new std::codecvt_utf8<wchar_t>);
         corpusStream.imbue(utf8);
-#endif
         if (!corpusStream.is_open())
             return false;
 
-        return LoadDictionary(corpusStream, termIndex, countIndex, separatorChars);
+        return LoadDictionary(corpusStream, termIndex, countIndex, separatorChars, threads);
+#endif
     }
 
-    bool SymSpell::LoadDictionary(xifstream &corpusStream, int termIndex, int countIndex, xchar separatorChars)
+    bool SymSpell::LoadDictionary(xifstream &corpusStream, int termIndex, int countIndex, xchar separatorChars,
+                                  int threads)
     {
-        auto staging = std::make_shared<SuggestionStage>(16384);
+        threads = Helpers::ResolveThreadCount(threads);
+        std::vector<uint32_t> wordIds;
+        std::vector<xstring_view> columns;
         xstring line;
-        int i = 0;
-        int start, end;
-        start = clock();
         while (getline(corpusStream, line))
-        {
-            i++;
-            std::vector<xstring> lineParts;
-            xstringstream ss(line);
-            xstring token;
-            while (getline(ss, token, separatorChars))
-                lineParts.push_back(token);
-            if (lineParts.size() >= 2)
-            {
-                int64_t count = 1;
-                try
-                {
-                    count = std::stoll(lineParts[countIndex]);
-                }
-                catch (const std::invalid_argument &)
-                {
-                    // Do nothing
-                }
-                CreateDictionaryEntry(lineParts[termIndex], count, staging);
-            }
-            else
-            {
-                CreateDictionaryEntry(line, 1, staging);
-            }
-        }
-        CommitStaged(staging);
+            LoadDictionaryLine(line, termIndex, countIndex, separatorChars, columns, wordIds);
+        CommitDeletes(wordIds, threads);
         if (EntryCount() == 0)
             return false;
         return true;
     }
 
-    bool SymSpell::CreateDictionary(const std::string &corpus)
+    void SymSpell::LoadDictionaryLine(xstring_view line, int termIndex, int countIndex, xchar separatorChars,
+                                      std::vector<xstring_view> &columns, std::vector<uint32_t> &wordIds)
+    {
+        DictionaryParser::SplitColumns(line, separatorChars, columns);
+        uint32_t wordId;
+        if (columns.size() >= 2)
+        {
+            auto column = [&columns](int index)
+            { return index < columns.size() ? columns[index] : xstring_view(); };
+            int64_t count;
+            if (!DictionaryParser::ParseCount(column(countIndex), count))
+                count = 1;
+            wordId = CountDictionaryEntry(column(termIndex), count);
+        }
+        else
+        {
+            wordId = CountDictionaryEntry(line, 1);
+        }
+        if (wordId != TermArena::npos)
+            wordIds.push_back(wordId);
+    }
+
+    bool SymSpell::CreateDictionary(const std::string &corpus, int threads)
     {
         xifstream corpusStream;
         corpusStream.open(corpus);
@@ -299,21 +439,27 @@ namespace symspellcpppy
         if (!corpusStream.is_open())
             return false;
 
-        return CreateDictionary(corpusStream);
+        return CreateDictionary(corpusStream, threads);
     }
 
-    bool SymSpell::CreateDictionary(xifstream &corpusStream)
+    bool SymSpell::CreateDictionary(xifstream &corpusStream, int threads)
     {
-        xstring line;
-        auto staging = std::make_shared<SuggestionStage>(16384);
+        threads = Helpers::ResolveThreadCount(threads);
+        std::vector<uint32_t> wordIds;
+        xstring line, lowerLine;
+        std::vector<xstring_view> words;
         while (getline(corpusStream, line))
         {
-            for (const xstring &key : ParseWords(line))
+            Helpers::string_lower(line, lowerLine);
+            ParseWords(lowerLine, words);
+            for (xstring_view key : words)
             {
-                CreateDictionaryEntry(key, 1, staging);
+                uint32_t wordId = CountDictionaryEntry(key, 1);
+                if (wordId != TermArena::npos)
+                    wordIds.push_back(wordId);
             }
         }
-        CommitStaged(staging);
+        CommitDeletes(wordIds, threads);
         if (EntryCount() == 0)
             return false;
         return true;
@@ -326,57 +472,407 @@ namespace symspellcpppy
 
     void SymSpell::CommitStaged(const std::shared_ptr<SuggestionStage> &staging)
     {
+        if (frozen)
+            throw std::logic_error("Cannot add entries to a frozen dictionary");
+        ClearLookupCache();
         if (deletes == nullptr)
-            deletes = std::make_shared<std::unordered_map<int, std::vector<xstring>>>(staging->DeleteCount());
+            deletes = std::make_shared<std::unordered_map<int, PostingList>>(staging->DeleteCount());
         staging->CommitTo(deletes);
     }
 
-    std::vector<SuggestItem> SymSpell::Lookup(const xstring &input, Verbosity verbosity)
+    void SymSpell::CommitDeletes(const std::vector<uint32_t> &wordIds, int threads)
+    {
+        if (frozen)
+            throw std::logic_error("Cannot add entries to a frozen dictionary");
+        // below a few thousand words per thread starting the threads costs more than it saves
+        threads = std::max(1, std::min(threads, (int)(wordIds.size() / 4096)));
+        size_t chunkSize = (wordIds.size() + threads - 1) / threads;
+
+        // every thread stages the deletes of a contiguous run of the words
+        std::vector<SuggestionStage> stages;
+        stages.reserve(threads);
+        for (int t = 0; t < threads; t++)
+            stages.emplace_back(16384);
+        Helpers::ParallelFor(threads, [&](int t)
+                             {
+            DeleteEnumerator edits;
+            size_t last = std::min(wordIds.size(), (t + 1) * chunkSize);
+            for (size_t i = t * chunkSize; i < last; i++)
+            {
+                uint32_t wordId = wordIds[i];
+                EditsPrefix(terms.View(wordId), edits);
+                for (size_t e = 0; e < edits.Size(); e++)
+                {
+                    stages[t].Add(GetstringHash(edits[e]), wordId);
+                }
+            } });
+
+        if (threads == 1)
+        {
+            if (deletes == nullptr)
+                deletes = std::make_shared<std::unordered_map<int, PostingList>>(stages[0].DeleteCount());
+            stages[0].CommitTo(deletes);
+            return;
+        }
+
+        // A stage lists the words of a delete newest first, so walking the stages from the last run of words
+        // to the first gives the order of a single stage. Every thread merges the deletes of one hash partition.
+        std::vector<std::unordered_map<int, PostingList>> partitions(threads);
+        auto partitionOf = [threads](int deleteHash)
+        { return (int)((((uint32_t)deleteHash * 2654435761u) >> 16) % (uint32_t)threads); };
+        Helpers::ParallelFor(threads, [&](int p)
+                             {
+            auto inPartition = [&](int deleteHash) { return partitionOf(deleteHash) == p; };
+            for (int t = threads - 1; t >= 0; t--)
+                stages[t].CommitTo(partitions[p], inPartition); });
+        stages.clear();
+
+        if (deletes == nullptr)
+        {
+            size_t deleteCount = 0;
+            for (const auto &partition : partitions)
+                deleteCount += partition.size();
+            deletes = std::make_shared<std::unordered_map<int, PostingList>>(deleteCount);
+        }
+        for (auto &partition : partitions)
+        {
+            for (auto &merged : partition)
+            {
+                PostingList &suggestions = (*deletes)[merged.first];
+                if (suggestions.empty())
+                    suggestions = std::move(merged.second);
+                else
+                    suggestions.append(merged.second.begin(), merged.second.end());
+            }
+            partition.clear();
+        }
+    }
+
+    void SymSpell::Freeze()
+    {
+        Freeze(postingCodec);
+    }
+
+    void SymSpell::Freeze(PostingCodec codec)
+    {
+        if (frozen)
+            return;
+        if (!PostingCoder::Valid((uint32_t)codec))
+            throw std::invalid_argument("Unknown posting codec.");
+        if (deletes != nullptr)
+        {
+            // Renumber the words shortest first and the most frequent first within a length, so the ascending ids
+            // of a delete bucket come in the order LookupWith searches them in, and compress as small gaps.
+            std::vector<uint32_t> order(terms.Size());
+            for (uint32_t id = 0; id < order.size(); id++)
+                order[id] = id;
+            std::stable_sort(order.begin(), order.end(), [this](uint32_t l, uint32_t r)
+                             { return terms.Length(l) < terms.Length(r) ||
+                                      (terms.Length(l) == terms.Length(r) && wordCounts[l] > wordCounts[r]); });
+            std::vector<uint32_t> newIds(order.size());
+            TermArena renumberedTerms;
+            FlatArray<int64_t> renumberedCounts;
+            FlatArray<WordInfo> renumberedInfos;
+            renumberedTerms.Reserve((uint32_t)order.size());
+            renumberedCounts.reserve(order.size());
+            renumberedInfos.reserve(order.size());
+            for (uint32_t newId = 0; newId < order.size(); newId++)
+            {
+                newIds[order[newId]] = newId;
+                renumberedTerms.Intern(terms.View(order[newId]));
+                renumberedCounts.push_back(wordCounts[order[newId]]);
+                renumberedInfos.push_back(wordInfos[order[newId]]);
+            }
+            frozenIndex.Build(*deletes, newIds, codec);
+            wordLengthStarts.clear();
+            for (uint32_t newId = 0; newId < order.size(); newId++)
+            {
+                while ((int)wordLengthStarts.size() <= terms.Length(order[newId]))
+                    wordLengthStarts.push_back(newId);
+            }
+            terms = std::move(renumberedTerms);
+            wordCounts = std::move(renumberedCounts);
+            wordInfos = std::move(renumberedInfos);
+        }
+        deletes = nullptr;
+
+        // bigrams are interned in key order, so equal dictionaries always freeze to the same bytes
+        std::vector<const std::pair<const xstring, long> *> sortedBigrams;
+        sortedBigrams.reserve(bigrams.size());
+        for (const auto &bigram : bigrams)
+            sortedBigrams.push_back(&bigram);
+        std::sort(sortedBigrams.begin(), sortedBigrams.end(), [](const auto *a, const auto *b)
+                  { return a->first < b->first; });
+        frozenBigrams.Reserve((uint32_t)sortedBigrams.size());
+        frozenBigramCounts.reserve(sortedBigrams.size());
+        for (const auto *bigram : sortedBigrams)
+        {
+            if (frozenBigrams.Intern(bigram->first) == frozenBigramCounts.size())
+                frozenBigramCounts.push_back(bigram->second);
+        }
+        terms.Freeze();
+        frozenBigrams.Freeze();
+        std::unordered_map<xstring, long>().swap(bigrams);
+        // no entry can be added anymore, so no word below the threshold can reach it
+        std::unordered_map<xstring, int64_t>().swap(belowThresholdWords);
+        frozen = true;
+    }
+
+    void SymSpell::SaveSnapshot(const std::string &path)
+    {
+        Freeze();
+        std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!out.is_open())
+            throw std::invalid_argument("Cannot save to file: " + path);
+
+        SnapshotHeader header{};
+        header.charSize = sizeof(xchar);
+        header.maxDictionaryEditDistance = maxDictionaryEditDistance;
+        header.prefixLength = prefixLength;
+        header.compactMask = compactMask;
+        header.maxDictionaryWordLength = maxDictionaryWordLength;
+        header.postingCodec = (uint32_t)frozenIndex.Codec();
+        header.countThreshold = countThreshold;
+        header.wordCount = wordCount;
+        header.entryCount = frozenIndex.EntryCount();
+        header.bigramCountMin = bigramCountMin;
+
+        SnapshotWriter writer;
+        terms.WriteSections(writer);
+        writer.Add(SnapshotSectionId::WordCounts, wordCounts);
+        writer.Add(SnapshotSectionId::WordInfos, wordInfos);
+        writer.Add(SnapshotSectionId::WordLengthStarts, wordLengthStarts);
+        frozenIndex.WriteSections(writer);
+        frozenBigrams.WriteSections(writer, TermArena::BigramSections);
+        writer.Add(SnapshotSectionId::BigramCounts, frozenBigramCounts);
+        writer.Write(out, header);
+    }
+
+    void SymSpell::LoadSnapshot(const std::string &path)
+    {
+        auto file = std::make_shared<MappedFile>(path);
+        SnapshotReader reader(file->Data(), file->Size());
+        const SnapshotHeader &header = reader.Header();
+
+        TermArena snapshotTerms;
+        FlatArray<int64_t> snapshotCounts;
+        FlatArray<WordInfo> snapshotInfos;
+        FlatArray<uint32_t> snapshotLengthStarts;
+        TermArena snapshotBigrams;
+        FlatArray<int64_t> snapshotBigramCounts;
+        FrozenIndex snapshotIndex;
+        snapshotTerms.ReadSections(reader);
+        reader.Borrow(SnapshotSectionId::WordCounts, snapshotCounts);
+        reader.Borrow(SnapshotSectionId::WordInfos, snapshotInfos);
+        reader.Borrow(SnapshotSectionId::WordLengthStarts, snapshotLengthStarts);
+        snapshotIndex.ReadSections(reader, (uint32_t) header.entryCount, header.postingCodec);
+        snapshotBigrams.ReadSections(reader, TermArena::BigramSections);
+        reader.Borrow(SnapshotSectionId::BigramCounts, snapshotBigramCounts);
+        if (snapshotCounts.size() != snapshotTerms.Size())
+            throw std::invalid_argument("Corrupt snapshot: inconsistent word counts");
+        if (snapshotInfos.size() != snapshotTerms.Size())
+            throw std::invalid_argument("Corrupt snapshot: inconsistent word infos");
+        for (size_t i = 0; i < snapshotLengthStarts.size(); i++)
+        {
+            if (snapshotLengthStarts[i] > snapshotTerms.Size() || (i > 0 && snapshotLengthStarts[i] < snapshotLengthStarts[i - 1]))
+                throw std::invalid_argument("Corrupt snapshot: inconsistent word lengths");
+        }
+        if (snapshotBigramCounts.size() != snapshotBigrams.Size())
+            throw std::invalid_argument("Corrupt snapshot: inconsistent bigram counts");
+        if (header.prefixLength < 1 || header.prefixLength > DeleteEnumerator::MaxWordLength)
+            throw std::invalid_argument("Corrupt snapshot: invalid prefix length");
+        if (header.maxDictionaryEditDistance < 0 || header.maxDictionaryEditDistance >= header.prefixLength ||
+            header.maxDictionaryEditDistance > DeleteEnumerator::MaxWordLength)
+            throw std::invalid_argument("Corrupt snapshot: invalid max edit distance");
+
+        maxDictionaryEditDistance = header.maxDictionaryEditDistance;
+        prefixLength = header.prefixLength;
+        compactMask = header.compactMask;
+        maxDictionaryWordLength = header.maxDictionaryWordLength;
+        countThreshold = header.countThreshold;
+        wordCount = (int) header.wordCount;
+        terms = std::move(snapshotTerms);
+        wordCounts = std::move(snapshotCounts);
+        wordInfos = std::move(snapshotInfos);
+        wordLengthStarts = std::move(snapshotLengthStarts);
+        frozenIndex = std::move(snapshotIndex);
+        frozenBigrams = std::move(snapshotBigrams);
+        frozenBigramCounts = std::move(snapshotBigramCounts);
+        bigramCountMin = header.bigramCountMin;
+        deletes = nullptr;
+        bigrams.clear();
+        belowThresholdWords.clear();
+        frozen = true;
+        snapshot = file;
+        ClearLookupCache();
+    }
+
+    std::vector<SuggestItem> SymSpell::Lookup(xstring_view input, Verbosity verbosity) const
     {
         return Lookup(input, verbosity, maxDictionaryEditDistance, false, false);
     }
 
-    std::vector<SuggestItem> SymSpell::Lookup(const xstring &input, Verbosity verbosity, int maxEditDistance)
+    std::vector<SuggestItem> SymSpell::Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance) const
     {
         return Lookup(input, verbosity, maxEditDistance, false, false);
     }
 
-    std::vector<SuggestItem> SymSpell::Lookup(const xstring &input, Verbosity verbosity, int maxEditDistance, bool includeUnknown)
+    std::vector<SuggestItem> SymSpell::Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown) const
     {
         return Lookup(input, verbosity, maxEditDistance, includeUnknown, false);
     }
 
     std::vector<SuggestItem>
-    SymSpell::Lookup(const xstring &original_input, Verbosity verbosity, int maxEditDistance, bool includeUnknown,
-                     bool transferCasing)
+    SymSpell::Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown,
+                     bool transferCasing) const
     {
-        if (deletes == nullptr)
-            return std::vector<SuggestItem>{}; // Dictionary is empty
+        return Lookup(input, verbosity, maxEditDistance, includeUnknown, transferCasing, DEFAULT_TOP_K);
+    }
+
+    std::vector<SuggestItem>
+    SymSpell::Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown,
+                     bool transferCasing, int k) const
+    {
+        LookupContext &context = ThreadLookupContext();
+        Lookup(input, verbosity, maxEditDistance, includeUnknown, transferCasing, context, k);
+        return std::move(context.suggestions);
+    }
+
+    bool SymSpell::LookupTop(xstring_view input, int maxEditDistance, SuggestItem &best) const
+    {
+        const std::vector<SuggestItem> &suggestions = Lookup(input, Top, maxEditDistance, false, false,
+                                                             ThreadLookupContext());
+        if (suggestions.empty())
+            return false;
+        best = suggestions[0];
+        return true;
+    }
+
+    const std::vector<SuggestItem> &
+    SymSpell::Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown,
+                     bool transferCasing, LookupContext &context, int k) const
+    {
+        if (verbosity != TopK)
+            k = 0; // only part of the cache key for TopK
+        else if (k < 1)
+            throw std::invalid_argument("k must be larger than 0");
+        context.stats = LookupStats();
+        context.stats.lookups = 1;
+        // known words are cheaper to answer than a cache hit, the single probe also serves the search otherwise
+        uint32_t inputId = TermArena::npos;
+        if (!transferCasing && LookupKnownWord(input, verbosity, maxEditDistance, k, inputId, context.suggestions))
+        {
+            lookupCounters.Add(context.stats);
+            return context.suggestions;
+        }
+        LookupCache::Key key{input, verbosity, maxEditDistance, includeUnknown, transferCasing, k};
+        if (lookupCache != nullptr && lookupCache->Find(key, context.suggestions))
+            return context.suggestions;
+        if (distanceAlgorithm == DistanceAlgorithm::LevenshteinDistance)
+            LookupWith<LevenshteinPolicy>(input, inputId, verbosity, maxEditDistance, includeUnknown,
+                                          transferCasing, k, context);
+        else
+            LookupWith<DamerauOSAPolicy>(input, inputId, verbosity, maxEditDistance, includeUnknown,
+                                         transferCasing, k, context);
+        lookupCounters.Add(context.stats);
+        if (lookupCache != nullptr)
+            lookupCache->Insert(key, context.suggestions);
+        return context.suggestions;
+    }
+
+    void SymSpell::EnableLookupCache(size_t memoryBudget, int shards)
+    {
+        if (shards < 1)
+            throw std::invalid_argument("shards must be larger than 0");
+        lookupCache = memoryBudget == 0 ? nullptr : std::make_shared<LookupCache>(memoryBudget, shards);
+    }
+
+    LookupCache::Stats SymSpell::LookupCacheStats() const
+    {
+        return lookupCache == nullptr ? LookupCache::Stats() : lookupCache->GetStats();
+    }
+
+    void SymSpell::ClearLookupCache()
+    {
+        if (lookupCache != nullptr)
+            lookupCache->Clear();
+    }
+
+    bool SymSpell::FindBigram(const xstring &bigram, int64_t &count) const
+    {
+        // bigrams loaded after freezing stay in the map
+        if (!bigrams.empty())
+        {
+            auto found = bigrams.find(bigram);
+            if (found != bigrams.end())
+            {
+                count = found->second;
+                return true;
+            }
+        }
+        uint32_t id = frozenBigrams.Find(bigram);
+        if (id == TermArena::npos)
+            return false;
+        count = frozenBigramCounts[id];
+        return true;
+    }
+
+    bool SymSpell::LookupKnownWord(xstring_view input, Verbosity verbosity, int maxEditDistance, int k,
+                                   uint32_t &inputId, std::vector<SuggestItem> &suggestions) const
+    {
+        inputId = terms.Find(input);
+        // the cases where LookupWith wouldn't return the input alone, or throws
+        if (inputId == TermArena::npos || wordCounts[inputId] < 0 || verbosity == All ||
+            (verbosity == TopK && k != 1) || maxEditDistance < 0 || maxEditDistance > maxDictionaryEditDistance ||
+            (deletes == nullptr && frozenIndex.Empty()))
+            return false;
+        suggestions.clear();
+        suggestions.emplace_back(xstring(input), 0, wordCounts[inputId]);
+        return true;
+    }
+
+    LookupStats SymSpell::GetLookupStats() const
+    {
+        return lookupCounters.Get();
+    }
+
+    void SymSpell::ResetLookupStats()
+    {
+        lookupCounters.Reset();
+    }
+
+    template <class DistancePolicy>
+    void SymSpell::LookupWith(xstring_view original_input, uint32_t inputId, Verbosity verbosity, int maxEditDistance,
+                              bool includeUnknown, bool transferCasing, int k, LookupContext &context) const
+    {
+        std::vector<SuggestItem> &suggestions = context.suggestions;
+        suggestions.clear();
+        if (deletes == nullptr && frozenIndex.Empty())
+            return; // Dictionary is empty
 
         int skip = 0;
         if (maxEditDistance > maxDictionaryEditDistance)
             throw std::invalid_argument("Distance too large");
 
-        xstring lower_input;
-
         if (transferCasing)
         {
-            lower_input = Helpers::string_lower(original_input);
+            Helpers::string_lower(original_input, context.lowerInput);
         }
 
-        const xstring &input = transferCasing ? lower_input : original_input;
+        xstring_view input = transferCasing ? xstring_view(context.lowerInput) : original_input;
 
-        std::vector<SuggestItem> suggestions;
         int inputLen = input.size();
         if (inputLen - maxEditDistance > maxDictionaryWordLength)
             skip = 1;
 
         int64_t suggestionCount = 0;
-        if (words.count(input) && !skip)
+        if (transferCasing)
+            inputId = terms.Find(input);
+        if (inputId != TermArena::npos && wordCounts[inputId] >= 0 && !skip)
         {
-            suggestionCount = words.at(input);
-            suggestions.emplace_back(transferCasing ? original_input : input, 0, suggestionCount);
-            if (verbosity != All)
+            suggestionCount = wordCounts[inputId];
+            suggestions.emplace_back(xstring(transferCasing ? original_input : input), 0, suggestionCount);
+            if (verbosity != All && (verbosity != TopK || k == 1))
                 skip = 1;
         }
 
@@ -385,29 +881,31 @@ namespace symspellcpppy
 
         if (!skip)
         {
-            std::unordered_set<xstring> hashset1;
-            std::unordered_set<xstring> hashset2;
-            hashset2.insert(input);
+            IdSet &hashset2 = context.seenSuggestions;
+            hashset2.Clear();
 
             int maxEditDistance2 = maxEditDistance;
-            int candidatePointer = 0;
-            std::deque<xstring> candidates;
-
-            int inputPrefixLen = inputLen;
-            if (inputPrefixLen > prefixLength)
-            {
-                inputPrefixLen = prefixLength;
-                candidates.emplace_back(input.substr(0, inputPrefixLen));
-            }
-            else
-            {
-                candidates.emplace_back(input);
-            }
-            auto distanceComparer = EditDistance(distanceAlgorithm);
-            while (candidatePointer < candidates.size())
+            size_t candidatePointer = 0;
+            xstring &candidate = context.candidate;
+
+            int inputPrefixLen = std::min(inputLen, prefixLength);
+            // the candidates are the deletes of the input prefix, in the order they are generated
+            DeleteEnumerator &candidates = context.candidates;
+            candidates.Reset(input.substr(0, inputPrefixLen));
+            // suggestions of a bucket needing the edit distance are scored together against the input's match vectors
+            const int unverified = -2;
+            auto &screened = context.screened;
+            auto &unverifiedSuggestions = context.unverifiedSuggestions;
+            auto &distances = context.distances;
+            PatternMasks &inputMasks = context.inputMasks;
+            bool inputMasked = inputLen > 0 && inputLen <= BitVectorDistance::MaxLength;
+            if (inputMasked)
+                inputMasks.Reset(input);
+            const uint64_t inputSignature = CharSignature::Of(input);
+            while (candidatePointer < candidates.Size())
             {
-                const xstring &candidate = candidates[candidatePointer++];
-                int candidateLen = candidate.size();
+                const DeleteEnumerator::Delete candidateDelete = candidates[candidatePointer++];
+                int candidateLen = candidateDelete.length;
                 int lengthDiff = inputPrefixLen - candidateLen;
 
                 if (lengthDiff > maxEditDistance2)
@@ -417,115 +915,238 @@ namespace symspellcpppy
                     break;
                 }
 
-                auto deletes_found = deletes->find(GetstringHash(candidate));
+                // the delete is only spelled out once a suggestion of its bucket needs the string,
+                // most buckets are empty or only hold suggestions the length checks already drop
+                bool candidateMaterialized = false;
+                auto candidateString = [&]() -> const xstring &
+                {
+                    if (!candidateMaterialized)
+                    {
+                        candidates.Materialize(candidateDelete, candidate);
+                        candidateMaterialized = true;
+                    }
+                    return candidate;
+                };
 
-                // read candidate entry from std::unordered_map
-                if (deletes_found != deletes->end())
+                // the checks of a suggestion's length against the current best distance
+                auto withinDistance = [&](const WordInfo &info)
                 {
-                    for (const xstring &suggestion : deletes_found->second)
+                    int suggPrefixLen = info.PrefixLength();
+                    return abs(info.Length() - inputLen) <= maxEditDistance2 &&
+                           !(suggPrefixLen > inputPrefixLen && (suggPrefixLen - candidateLen) > maxEditDistance2);
+                };
+
+                // screens one suggestion of the candidate's delete bucket
+                // returns its distance, -1 to drop it, or unverified if it needs the full edit distance
+                auto screenSuggestion = [&](uint32_t suggestionId)
+                {
+                    const WordInfo &info = wordInfos[suggestionId];
+                    int suggestionLen = info.Length();
+                    if (suggestionId == inputId)
+                        return -1;
+                    if (!withinDistance(info) // input and sugg lengths diff > allowed/current best distance
+                        || (suggestionLen <
+                            candidateLen)) // sugg must be for a different delete string, in same bin only because of hash collision
+                        return -1;
+                    // the term's characters are only needed from here on
+                    xstring_view suggestion = terms.View(suggestionId);
+                    if (suggestionLen == candidateLen && suggestion != candidateString()) // if sugg len = delete len, then it either equals delete or is in same bin only because of hash collision
+                        return -1;
+
+                    int distance = 0;
+                    int min_len = 0;
+                    if (candidateLen == 0)
                     {
-                        int suggestionLen = suggestion.size();
-                        if (suggestion == input)
-                            continue;
-                        if ((abs(suggestionLen - inputLen) >
-                             maxEditDistance2) // input and sugg lengths diff > allowed/current best distance
-                            || (suggestionLen <
-                                candidateLen) // sugg must be for a different delete string, in same bin only because of hash collision
-                            || (suggestionLen == candidateLen && suggestion !=
-                                                                     candidate)) // if sugg len = delete len, then it either equals delete or is in same bin only because of hash collision
-                            continue;
-                        auto suggPrefixLen = std::min(suggestionLen, prefixLength);
-                        if (suggPrefixLen > inputPrefixLen &&
-                            (suggPrefixLen - candidateLen) > maxEditDistance2)
-                            continue;
+                        // suggestions which have no common chars with input (inputLen<=maxEditDistance && suggestionLen<=maxEditDistance)
+                        distance = std::max(inputLen, suggestionLen);
+                        bool inserted = hashset2.Insert(suggestionId);
+                        if (distance > maxEditDistance2 || !inserted)
+                            return -1;
+                    }
+                    else if (suggestionLen == 1)
+                    {
+                        if (input.find(suggestion[0]) == xstring_view::npos)
+                            distance = inputLen;
+                        else
+                            distance = inputLen - 1;
 
-                        int distance = 0;
-                        int min_len = 0;
-                        if (candidateLen == 0)
+                        bool inserted = hashset2.Insert(suggestionId);
+                        if (distance > maxEditDistance2 || !inserted)
+                            return -1;
+                    }
+                    else if ((prefixLength - maxEditDistance == candidateLen) && (((min_len = std::min(inputLen, suggestionLen) - prefixLength) > 1) && (input.substr(inputLen + 1 - min_len) !=
+                                                                                                                                                         suggestion.substr(suggestionLen + 1 - min_len))) ||
+                             ((min_len > 0) && (input[inputLen - min_len] != suggestion[suggestionLen - min_len]) && ((input[inputLen - min_len - 1] != suggestion[suggestionLen - min_len]) || (input[inputLen - min_len] != suggestion[suggestionLen - min_len - 1]))))
+                    {
+                        return -1;
+                    }
+                    else
+                    {
+                        if ((verbosity != All &&
+                             !DeleteInSuggestionPrefix(candidateString(), candidateLen, suggestion, suggestionLen)) ||
+                            !hashset2.Insert(suggestionId))
+                            return -1;
+                        // the characters missing from either word may already rule it out
+                        if (CharSignature::DistanceBound(inputSignature, info.signature) > maxEditDistance2)
                         {
-                            // suggestions which have no common chars with input (inputLen<=maxEditDistance && suggestionLen<=maxEditDistance)
-                            distance = std::max(inputLen, suggestionLen);
-                            auto flag = hashset2.insert(suggestion);
-                            if (distance > maxEditDistance2 || !flag.second)
-                                continue;
+                            context.stats.signatureRejections++;
+                            return -1;
                         }
-                        else if (suggestionLen == 1)
+                        return unverified;
+                    }
+                    return distance;
+                };
+
+                // adds a screened suggestion, unless an earlier suggestion of the bucket lowered the best distance below it
+                auto addSuggestion = [&](uint32_t suggestionId, int distance)
+                {
+                    if (distance < 0 || distance > maxEditDistance2 || !withinDistance(wordInfos[suggestionId]))
+                        return;
+                    xstring_view suggestion = terms.View(suggestionId);
+
+                    suggestionCount = wordCounts[suggestionId];
+                    if (verbosity == TopK)
+                    {
+                        // suggestions is a heap of the best k so far, the worst of them in front
+                        auto worstFirst = [](const SuggestItem &l, const SuggestItem &r)
+                        { return l.CompareTo(r) < 0; };
+                        if ((int)suggestions.size() < k)
                         {
-                            if (input.find(suggestion[0]) == xstring::npos)
-                                distance = inputLen;
-                            else
-                                distance = inputLen - 1;
-
-                            auto flag = hashset2.insert(suggestion);
-                            if (distance > maxEditDistance2 || !flag.second)
-                                continue;
+                            suggestions.emplace_back(xstring(suggestion), distance, suggestionCount);
                         }
-                        else if ((prefixLength - maxEditDistance == candidateLen) && (((min_len = std::min(inputLen, suggestionLen) - prefixLength) > 1) && (input.substr(inputLen + 1 - min_len) !=
-                                                                                                                                                             suggestion.substr(suggestionLen + 1 - min_len))) ||
-                                 ((min_len > 0) && (input[inputLen - min_len] != suggestion[suggestionLen - min_len]) && ((input[inputLen - min_len - 1] != suggestion[suggestionLen - min_len]) || (input[inputLen - min_len] != suggestion[suggestionLen - min_len - 1]))))
+                        else
                         {
-                            continue;
+                            const SuggestItem &worst = suggestions.front();
+                            if (distance > worst.distance ||
+                                (distance == worst.distance && (suggestionCount < worst.count ||
+                                                                (suggestionCount == worst.count &&
+                                                                 suggestion >= xstring_view(worst.term)))))
+                                return;
+                            std::pop_heap(suggestions.begin(), suggestions.end(), worstFirst);
+                            // reuse the term's storage
+                            suggestions.back().term.assign(suggestion.begin(), suggestion.end());
+                            suggestions.back().distance = distance;
+                            suggestions.back().count = suggestionCount;
                         }
-                        else
+                        std::push_heap(suggestions.begin(), suggestions.end(), worstFirst);
+                        // once k are found, anything farther than the worst of them can't make it in
+                        if ((int)suggestions.size() == k)
+                            maxEditDistance2 = suggestions.front().distance;
+                        return;
+                    }
+                    if (!suggestions.empty())
+                    {
+                        switch (verbosity)
+                        {
+                        case Closest:
                         {
-                            if ((verbosity != All &&
-                                 !DeleteInSuggestionPrefix(candidate, candidateLen, suggestion, suggestionLen)) ||
-                                !hashset2.insert(suggestion).second)
-                                continue;
-                            distance = distanceComparer.Compare(input, suggestion, maxEditDistance2);
-                            if (distance < 0)
-                                continue;
+                            if (distance < maxEditDistance2)
+                                suggestions.clear();
+                            break;
                         }
-
-                        if (distance <= maxEditDistance2)
+                        case Top:
                         {
-                            suggestionCount = words[suggestion];
-                            SuggestItem si = SuggestItem(suggestion, distance, suggestionCount);
-                            if (!suggestions.empty())
+                            if (distance < maxEditDistance2 || suggestionCount > suggestions[0].count)
                             {
-                                switch (verbosity)
-                                {
-                                case Closest:
-                                {
-                                    if (distance < maxEditDistance2)
-                                        suggestions.clear();
-                                    break;
-                                }
-                                case Top:
-                                {
-                                    if (distance < maxEditDistance2 || suggestionCount > suggestions[0].count)
-                                    {
-                                        maxEditDistance2 = distance;
-                                        suggestions[0] = si;
-                                    }
-                                    continue;
-                                }
-                                case All:
-                                    break;
-                                }
-                            }
-                            if (verbosity != All)
                                 maxEditDistance2 = distance;
-                            suggestions.push_back(si);
+                                // reuse the term's storage
+                                suggestions[0].term.assign(suggestion.begin(), suggestion.end());
+                                suggestions[0].distance = distance;
+                                suggestions[0].count = suggestionCount;
+                            }
+                            return;
                         }
-                    } // end foreach
-                }     // end if
-
-                if ((lengthDiff < maxEditDistance) && (candidateLen <= prefixLength))
+                        default:
+                            break;
+                        }
+                    }
+                    if (verbosity != All)
+                        maxEditDistance2 = distance;
+                    suggestions.emplace_back(xstring(suggestion), distance, suggestionCount);
+                };
+
+                const uint32_t *bucketFirst = nullptr;
+                const uint32_t *bucketLast = nullptr;
+                int candidateHash = GetstringHash(candidateDelete);
+                if (frozen)
                 {
-                    if (verbosity != All && lengthDiff >= maxEditDistance2)
-                        continue;
+                    auto postings = frozenIndex.Postings(candidateHash, context.postings);
+                    // frozen postings are sorted by word length, narrow them to the lengths withinDistance can accept
+                    int shortest = std::max(candidateLen, inputLen - maxEditDistance2);
+                    int longest = inputLen + maxEditDistance2;
+                    bucketFirst = std::lower_bound(postings.first, postings.second, FirstIdOfLength(shortest));
+                    bucketLast = std::lower_bound(bucketFirst, postings.second, FirstIdOfLength(longest + 1));
+                }
+                else
+                {
+                    auto deletes_found = deletes->find(candidateHash);
 
-                    for (int i = 0; i < candidateLen; i++)
+                    // read candidate entry from std::unordered_map
+                    if (deletes_found != deletes->end())
                     {
-                        xstring del(candidate);
-                        del.erase(i, 1);
+                        bucketFirst = deletes_found->second.data();
+                        bucketLast = bucketFirst + deletes_found->second.size();
+                    }
+                }
 
-                        if (hashset1.insert(del).second)
+                // Screen the whole bucket first, then compute the edit distances of the survivors in one batch.
+                // They are added in bucket order afterwards, so the result is the same as verifying them one by one.
+                screened.clear();
+                unverifiedSuggestions.clear();
+                // Once Top has a suggestion or TopK has k, a suggestion at the current best distance needs a higher
+                // count to get in, and no suggestion can be closer to the input than their difference in length.
+                // Frozen postings of one length come most frequent first, so the rest of a length whose length
+                // alone puts it at the best distance is skipped at the first count that can't win.
+                int64_t countToBeat = -1;
+                if (frozen && !suggestions.empty() &&
+                    (verbosity == Top || (verbosity == TopK && (int)suggestions.size() == k)))
+                    countToBeat = verbosity == Top ? suggestions[0].count + 1 : suggestions.front().count;
+                for (const uint32_t *posting = bucketFirst; posting != bucketLast; ++posting)
+                {
+                    if (countToBeat >= 0)
+                    {
+                        const WordInfo &info = wordInfos[*posting];
+                        int suggestionLen = info.Length();
+                        if (abs(suggestionLen - inputLen) >= maxEditDistance2 && info.CountBound() < countToBeat)
                         {
-                            candidates.push_back(del);
+                            posting = std::lower_bound(posting, bucketLast, FirstIdOfLength(suggestionLen + 1)) - 1;
+                            continue;
                         }
                     }
+                    int distance = screenSuggestion(*posting);
+                    if (distance == -1)
+                        continue;
+                    if (distance == unverified)
+                        unverifiedSuggestions.push_back(terms.View(*posting));
+                    screened.emplace_back(*posting, distance);
+                }
+                if (!unverifiedSuggestions.empty())
+                {
+                    context.stats.distanceComputations += unverifiedSuggestions.size();
+                    distances.resize(unverifiedSuggestions.size());
+                    if (inputMasked)
+                    {
+                        BitVectorDistance::Distances<DistancePolicy::Transpositions>(
+                            inputMasks, inputLen, unverifiedSuggestions.data(), unverifiedSuggestions.size(),
+                            maxEditDistance2, distances.data());
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < unverifiedSuggestions.size(); i++)
+                            distances[i] = DistancePolicy::Distance(input, unverifiedSuggestions[i], maxEditDistance2,
+                                                                    context.distanceScratch);
+                    }
+                }
+                size_t nextDistance = 0;
+                for (const auto &entry : screened)
+                    addSuggestion(entry.first, entry.second == unverified ? distances[nextDistance++] : entry.second);
+
+                if ((lengthDiff < maxEditDistance) && (candidateLen <= prefixLength))
+                {
+                    if (verbosity != All && lengthDiff >= maxEditDistance2)
+                        continue;
+
+                    candidates.AddDeletes(candidatePointer - 1);
                 }
             } // end while
 
@@ -535,18 +1156,79 @@ namespace symspellcpppy
 
             if (transferCasing)
             {
+                xstring originalInput(original_input);
                 for (auto &suggestion : suggestions)
                 {
-                    suggestion.term = Helpers::transfer_casing_for_similar_text(original_input, suggestion.term);
+                    suggestion.term = Helpers::transfer_casing_for_similar_text(originalInput, suggestion.term);
                 }
             }
         }
         if (includeUnknown && (suggestions.empty()))
-            suggestions.emplace_back(input, maxEditDistance + 1, 0);
-        return suggestions;
+            suggestions.emplace_back(xstring(input), maxEditDistance + 1, 0);
     } // end if
 
-    bool SymSpell::DeleteInSuggestionPrefix(const xstring &deleteSugg, int deleteLen, xstring suggestion,
+    SuggestionBatch SymSpell::LookupBatch(const std::vector<xstring_view> &inputs, Verbosity verbosity,
+                                          int maxEditDistance, int threads, bool includeUnknown, int k) const
+    {
+        if (maxEditDistance > maxDictionaryEditDistance)
+            throw std::invalid_argument("Distance too large");
+        if (verbosity == TopK && k < 1)
+            throw std::invalid_argument("k must be larger than 0");
+        threads = Helpers::ResolveThreadCount(threads);
+
+        SuggestionBatch batch;
+        std::vector<xstring_view> distinctInputs;
+        std::unordered_map<xstring_view, uint32_t> distinctSlots(inputs.size());
+        batch.slots.reserve(inputs.size());
+        for (xstring_view input : inputs)
+        {
+            auto slot = distinctSlots.emplace(input, (uint32_t)distinctInputs.size());
+            if (slot.second)
+                distinctInputs.push_back(input);
+            batch.slots.push_back(slot.first->second);
+        }
+
+        // known words are answered right away, only the others go to the threads
+        std::vector<std::vector<SuggestItem>> results(distinctInputs.size());
+        std::vector<uint32_t> searched;
+        uint32_t inputId;
+        for (uint32_t i = 0; i < distinctInputs.size(); i++)
+        {
+            if (!LookupKnownWord(distinctInputs[i], verbosity, maxEditDistance, k, inputId, results[i]))
+                searched.push_back(i);
+        }
+        LookupStats knownStats;
+        knownStats.lookups = distinctInputs.size() - searched.size();
+        lookupCounters.Add(knownStats);
+
+        // lookups differ a lot in cost, so the threads take small runs of words as they go instead of fixed chunks
+        const size_t runLength = 64;
+        threads = std::max(1, std::min(threads, (int)((searched.size() + runLength - 1) / runLength)));
+        std::atomic<size_t> nextRun(0);
+        Helpers::ParallelFor(threads, [&](int)
+                             {
+            for (size_t first = nextRun.fetch_add(runLength); first < searched.size(); first = nextRun.fetch_add(runLength))
+            {
+                size_t last = std::min(searched.size(), first + runLength);
+                for (size_t i = first; i < last; i++)
+                    results[searched[i]] = Lookup(distinctInputs[searched[i]], verbosity, maxEditDistance,
+                                                  includeUnknown, false, k);
+            } });
+
+        size_t suggestionCount = 0;
+        for (const auto &result : results)
+            suggestionCount += result.size();
+        batch.suggestions.reserve(suggestionCount);
+        batch.offsets.reserve(results.size() + 1);
+        for (auto &result : results)
+        {
+            std::move(result.begin(), result.end(), std::back_inserter(batch.suggestions));
+            batch.offsets.push_back(batch.suggestions.size());
+        }
+        return batch;
+    }
+
+    bool SymSpell::DeleteInSuggestionPrefix(xstring_view deleteSugg, int deleteLen, xstring_view suggestion,
                                             int suggestionLen) const
     {
         if (deleteLen == 0)
@@ -565,165 +1247,145 @@ namespace symspellcpppy
         return true;
     }
 
-    std::vector<xstring> SymSpell::ParseWords(const xstring &text)
+    void SymSpell::ParseWords(const xstring &text, std::vector<xstring_view> &words)
     {
-        xregex r(XL("['’\\w\\-\\[_\\]]+"));
+        static const xregex r(XL("['’\\w\\-\\[_\\]]+"));
         xsmatch m;
-        std::vector<xstring> matches;
+        words.clear();
         xstring::const_iterator ptr(text.cbegin());
         while (regex_search(ptr, text.cend(), m, r))
         {
-            xstring matchLower = Helpers::string_lower(m[0]);
-            matches.push_back(matchLower);
+            words.emplace_back(text.data() + (m[0].first - text.cbegin()), m[0].length());
             ptr = m.suffix().first;
         }
-        return matches;
     }
 
-    std::shared_ptr<std::unordered_set<xstring>>
-    SymSpell::Edits(const xstring &word, int editDistance, std::shared_ptr<std::unordered_set<xstring>> deleteWords)
+    void SymSpell::EditsPrefix(xstring_view key, DeleteEnumerator &edits) const
     {
-        editDistance++;
-        if (word.size() > 1)
+        // all strings of the prefix with up to maxDictionaryEditDistance characters removed, but at least one left
+        edits.Reset(key.substr(0, prefixLength));
+        int maxRemoved = std::max(1, maxDictionaryEditDistance);
+        for (size_t i = 0; i < edits.Size(); i++)
         {
-            for (int i = 0; i < word.size(); i++)
-            {
-                xstring temp(word);
-                xstring del = temp.erase(i, 1);
-                if (deleteWords->insert(del).second)
-                {
-                    if (editDistance < maxDictionaryEditDistance)
-                        Edits(del, editDistance, deleteWords);
-                }
-            }
+            if (edits[i].length > 1 && edits.RemovedCount(edits[i]) < maxRemoved)
+                edits.AddDeletes(i);
         }
-        return deleteWords;
-    }
-
-    std::shared_ptr<std::unordered_set<xstring>> SymSpell::EditsPrefix(const xstring &key)
-    {
-        auto m = std::make_shared<std::unordered_set<xstring>>();
         if (key.size() <= maxDictionaryEditDistance)
-            m->insert(XL(""));
-        if (key.size() > prefixLength)
-        {
-            const xstring sub_key = key.substr(0, prefixLength);
-            m->insert(sub_key);
-            Edits(sub_key, 0, m);
-        }
-        else
-        {
-            m->insert(key);
-            Edits(key, 0, m);
-        }
-        return m;
+            edits.Add(edits.EmptyMask());
     }
 
-    int SymSpell::GetstringHash(const xstring &s) const
+    int SymSpell::GetstringHash(const DeleteEnumerator::Delete &edit) const
     {
-        int len = s.size();
-        int lenMask = len;
+        int lenMask = edit.length;
         if (lenMask > 3)
             lenMask = 3;
 
-        unsigned int hash = 2166136261;
-        for (auto i = 0; i < len; i++)
-        {
-            hash ^= s[i];
-            hash *= 16777619;
-        }
-
+        unsigned int hash = edit.hash;
         hash &= compactMask;
         hash |= (unsigned int)lenMask;
         return (int)hash;
     }
 
-    std::vector<SuggestItem> SymSpell::LookupCompound(const xstring &input)
+    int SymSpell::Distance(xstring_view string1, xstring_view string2, int maxDistance) const
+    {
+        static thread_local DistanceScratch scratch;
+        if (distanceAlgorithm == DistanceAlgorithm::LevenshteinDistance)
+            return LevenshteinPolicy::Distance(string1, string2, maxDistance, scratch);
+        return DamerauOSAPolicy::Distance(string1, string2, maxDistance, scratch);
+    }
+
+    std::vector<SuggestItem> SymSpell::LookupCompound(xstring_view input) const
     {
         return LookupCompound(input, maxDictionaryEditDistance, false);
     }
 
-    std::vector<SuggestItem> SymSpell::LookupCompound(const xstring &input, int editDistanceMax)
+    std::vector<SuggestItem> SymSpell::LookupCompound(xstring_view input, int editDistanceMax) const
     {
         return LookupCompound(input, editDistanceMax, false);
     }
 
-    std::vector<SuggestItem> SymSpell::LookupCompound(const xstring &input, int editDistanceMax, bool transferCasing)
+    std::vector<SuggestItem> SymSpell::LookupCompound(xstring_view input, int editDistanceMax, bool transferCasing) const
     {
-        std::vector<xstring> termList1 = ParseWords(input);
-
-        std::vector<SuggestItem> suggestions;     // suggestions for a single term
+        // the terms are views into the lower case input, only the suggestions own their strings
+        xstring lowerInput;
+        Helpers::string_lower(input, lowerInput);
+        std::vector<xstring_view> termList1;
+        ParseWords(lowerInput, termList1);
+
+        // whether the suggestion of a split, first + second, spells the term without the space
+        auto spellsTerm = [](const xstring &first, const xstring &second, xstring_view term)
+        {
+            return first.size() + second.size() == term.size() && term.substr(0, first.size()) == first &&
+                   term.substr(first.size()) == second;
+        };
+
+        SuggestItem suggestion;                   // suggestion for a single term
+        SuggestItem suggestionCombi;              // suggestion for a term combined with the previous one
+        SuggestItem suggestion1, suggestion2;     // suggestions for the two parts of a split term
+        SuggestItem suggestionSplit;
+        xstring combinedTerm;
         std::vector<SuggestItem> suggestionParts; // 1 line with separate parts
-        auto distanceComparer = EditDistance(distanceAlgorithm);
-
         bool lastCombi = false;
         for (int i = 0; i < termList1.size(); i++)
         {
-            suggestions = Lookup(termList1[i], Top, editDistanceMax);
+            bool found = LookupTop(termList1[i], editDistanceMax, suggestion);
 
             if ((i > 0) && !lastCombi)
             {
-                std::vector<SuggestItem> suggestionsCombi = Lookup(termList1[i - 1] + termList1[i], Top,
-                                                                   editDistanceMax);
-
-                if (!suggestionsCombi.empty())
+                combinedTerm.assign(termList1[i - 1].begin(), termList1[i - 1].end());
+                combinedTerm.append(termList1[i].begin(), termList1[i].end());
+                if (LookupTop(combinedTerm, editDistanceMax, suggestionCombi))
                 {
-                    SuggestItem best1 = suggestionParts[suggestionParts.size() - 1];
-                    SuggestItem best2 = SuggestItem();
-                    if (!suggestions.empty())
+                    const SuggestItem &best1 = suggestionParts[suggestionParts.size() - 1];
+                    int best2Distance = editDistanceMax + 1;
+                    int64_t best2Count = (long)((double)10 / pow((double)10, (double)termList1[i].size())); // 0;
+                    if (found)
                     {
-                        best2 = suggestions[0];
-                    }
-                    else
-                    {
-                        best2.term = termList1[i];
-                        best2.distance = editDistanceMax + 1;
-                        best2.count = (long)((double)10 / pow((double)10, (double)best2.term.size())); // 0;
+                        best2Distance = suggestion.distance;
+                        best2Count = suggestion.count;
                     }
 
-                    int distance1 = best1.distance + best2.distance;
-                    if ((distance1 >= 0) && ((suggestionsCombi[0].distance + 1 < distance1) ||
-                                             ((suggestionsCombi[0].distance + 1 == distance1) &&
-                                              ((double)suggestionsCombi[0].count >
-                                               (double)best1.count / (double)N * (double)best2.count))))
+                    int distance1 = best1.distance + best2Distance;
+                    if ((distance1 >= 0) && ((suggestionCombi.distance + 1 < distance1) ||
+                                             ((suggestionCombi.distance + 1 == distance1) &&
+                                              ((double)suggestionCombi.count >
+                                               (double)best1.count / (double)N * (double)best2Count))))
                     {
-                        suggestionsCombi[0].distance++;
-                        suggestionParts[suggestionParts.size() - 1] = suggestionsCombi[0];
+                        suggestionCombi.distance++;
+                        suggestionParts[suggestionParts.size() - 1] = suggestionCombi;
                         lastCombi = true;
-                        goto nextTerm;
+                        continue;
                     }
                 }
             }
             lastCombi = false;
 
-            if ((!suggestions.empty()) && ((suggestions[0].distance == 0) || (termList1[i].size() == 1)))
+            if (found && ((suggestion.distance == 0) || (termList1[i].size() == 1)))
             {
-                suggestionParts.push_back(suggestions[0]);
+                suggestionParts.push_back(suggestion);
             }
             else
             {
                 SuggestItem suggestionSplitBest;
 
-                if (!suggestions.empty())
-                    suggestionSplitBest.set(suggestions[0]);
+                if (found)
+                    suggestionSplitBest.set(suggestion);
 
                 if (termList1[i].size() > 1)
                 {
                     for (int j = 1; j < termList1[i].size(); j++)
                     {
-                        xstring part1 = termList1[i].substr(0, j);
-                        xstring part2 = termList1[i].substr(j);
-                        SuggestItem suggestionSplit = SuggestItem();
-                        std::vector<SuggestItem> suggestions1 = Lookup(part1, Top, editDistanceMax);
-                        if (!suggestions1.empty())
+                        xstring_view part1 = termList1[i].substr(0, j);
+                        xstring_view part2 = termList1[i].substr(j);
+                        if (LookupTop(part1, editDistanceMax, suggestion1))
                         {
-                            std::vector<SuggestItem> suggestions2 = Lookup(part2, Top, editDistanceMax);
-                            if (!suggestions2.empty())
+                            if (LookupTop(part2, editDistanceMax, suggestion2))
                             {
-                                suggestionSplit.term = suggestions1[0].term + XL(" ") + suggestions2[0].term;
+                                suggestionSplit.term.assign(suggestion1.term);
+                                suggestionSplit.term += XL(' ');
+                                suggestionSplit.term += suggestion2.term;
 
-                                int distance2 = distanceComparer.Compare(termList1[i], suggestionSplit.term,
-                                                                         editDistanceMax);
+                                int distance2 = Distance(termList1[i], suggestionSplit.term, editDistanceMax);
                                 if (distance2 < 0)
                                     distance2 = editDistanceMax + 1;
 
@@ -736,38 +1398,38 @@ namespace symspellcpppy
                                 }
 
                                 suggestionSplit.distance = distance2;
-                                if (bigrams.count(suggestionSplit.term) > 0)
+                                int64_t bigramCount;
+                                if (FindBigram(suggestionSplit.term, bigramCount))
                                 {
-                                    long bigramCount = bigrams.at(suggestionSplit.term);
                                     suggestionSplit.count = bigramCount;
-                                    if (!suggestions.empty())
+                                    if (found)
                                     {
-                                        if ((suggestions1[0].term + suggestions2[0].term == termList1[i]))
+                                        if (spellsTerm(suggestion1.term, suggestion2.term, termList1[i]))
                                         {
                                             suggestionSplit.count = std::max(suggestionSplit.count,
-                                                                             suggestions[0].count + 2);
+                                                                             suggestion.count + 2);
                                         }
-                                        else if ((suggestions1[0].term == suggestions[0].term) ||
-                                                 (suggestions2[0].term == suggestions[0].term))
+                                        else if ((suggestion1.term == suggestion.term) ||
+                                                 (suggestion2.term == suggestion.term))
                                         {
                                             suggestionSplit.count = std::max(suggestionSplit.count,
-                                                                             suggestions[0].count + 1);
+                                                                             suggestion.count + 1);
                                         }
                                     }
-                                    else if ((suggestions1[0].term + suggestions2[0].term == termList1[i]))
+                                    else if (spellsTerm(suggestion1.term, suggestion2.term, termList1[i]))
                                     {
                                         suggestionSplit.count = std::max(suggestionSplit.count,
-                                                                         std::max(suggestions1[0].count,
-                                                                                  suggestions2[0].count) +
+                                                                         std::max(suggestion1.count,
+                                                                                  suggestion2.count) +
                                                                              2);
                                     }
                                 }
                                 else
                                 {
                                     suggestionSplit.count = std::min(bigramCountMin,
-                                                                     (int64_t)((double)suggestions1[0].count /
+                                                                     (int64_t)((double)suggestion1.count /
                                                                                (double)N *
-                                                                               (double)suggestions2[0].count));
+                                                                               (double)suggestion2.count));
                                 }
 
                                 if (suggestionSplitBest.count == 0 ||
@@ -783,53 +1445,48 @@ namespace symspellcpppy
                     }
                     else
                     {
-                        SuggestItem si = SuggestItem();
-                        si.term = termList1[i];
-                        si.count = (long)((double)10 / pow((double)10, (double)si.term.size()));
-                        si.distance = editDistanceMax + 1;
-                        suggestionParts.push_back(si);
+                        suggestionParts.emplace_back(xstring(termList1[i]), editDistanceMax + 1,
+                                                     (long)((double)10 / pow((double)10, (double)termList1[i].size())));
                     }
                 }
                 else
                 {
-                    SuggestItem si = SuggestItem();
-                    si.term = termList1[i];
-                    si.count = (long)((double)10 / pow((double)10, (double)si.term.size()));
-                    si.distance = editDistanceMax + 1;
-                    suggestionParts.push_back(si);
+                    suggestionParts.emplace_back(xstring(termList1[i]), editDistanceMax + 1,
+                                                 (long)((double)10 / pow((double)10, (double)termList1[i].size())));
                 }
             }
-        nextTerm:;
         }
 
         double count = N;
         xstring s;
         for (const SuggestItem &si : suggestionParts)
         {
-            s += (si.term + XL(" "));
+            s += si.term;
+            s += XL(' ');
             count *= (double)si.count / (double)N;
         }
         rtrim(s);
         if (transferCasing)
         {
-            s = Helpers::transfer_casing_for_similar_text(input, s);
+            s = Helpers::transfer_casing_for_similar_text(xstring(input), s);
         }
         std::vector<SuggestItem> suggestionsLine;
-        suggestionsLine.emplace_back(s, distanceComparer.Compare(input, s, MAXINT), (long)count);
+        int distance = Distance(input, s, INT_MAX);
+        suggestionsLine.emplace_back(std::move(s), distance, (long)count);
         return suggestionsLine;
     }
 
-    Info SymSpell::WordSegmentation(const xstring &input)
+    Info SymSpell::WordSegmentation(xstring_view input) const
     {
         return WordSegmentation(input, MaxDictionaryEditDistance(), maxDictionaryWordLength);
     }
 
-    Info SymSpell::WordSegmentation(const xstring &input, int maxEditDistance)
+    Info SymSpell::WordSegmentation(xstring_view input, int maxEditDistance) const
     {
         return WordSegmentation(input, maxEditDistance, maxDictionaryWordLength);
     }
 
-    Info SymSpell::WordSegmentation(const xstring &input, int maxEditDistance, int maxSegmentationWordLength)
+    Info SymSpell::WordSegmentation(xstring_view input, int maxEditDistance, int maxSegmentationWordLength) const
     {
         // v6.7
         // normalize ligatures:
@@ -838,41 +1495,49 @@ namespace symspellcpppy
         // TODO: Figure out how to do the below utf-8 normalization in C++.
         // input = input.Normalize(System.Text.NormalizationForm.FormKC).Replace("\u002D", "");//.Replace("\uC2AD","");
         int arraySize = std::min(maxSegmentationWordLength, (int)input.size());
+        if (arraySize <= 0)
+            return Info();
         std::vector<Info> compositions = std::vector<Info>(arraySize);
         int circularIndex = -1;
 
+        // buffers reused by every window of the input
+        xstring part, partLower, topResult, segmented, corrected;
+        SuggestItem top;
         for (int j = 0; j < input.size(); j++)
         {
             int imax = std::min((int)input.size() - j, maxSegmentationWordLength);
             for (int i = 1; i <= imax; i++)
             {
-                xstring part = input.substr(j, i);
+                xstring_view window = input.substr(j, i);
                 int separatorLength = 0;
                 int topEd = 0;
                 double topProbabilityLog = 0;
-                xstring topResult;
 
-                if (isxspace(part[0]))
+                if (isxspace(window[0]))
                 {
-                    part = part.substr(1);
+                    window.remove_prefix(1);
                 }
                 else
                 {
                     separatorLength = 1;
                 }
 
-                topEd += part.size();
-                xregex r(XL(" "));
-                part = regex_replace(part, r, XL(""));
+                // remove the spaces
+                topEd += window.size();
+                part.clear();
+                for (xchar c : window)
+                {
+                    if (c != XL(' '))
+                        part.push_back(c);
+                }
                 topEd -= part.size();
 
                 // v6.7
                 // Lookup against the lowercase term
-                auto partLower = Helpers::string_lower(part);
-                std::vector<SuggestItem> results = Lookup(partLower, Top, maxEditDistance);
-                if (!results.empty())
+                Helpers::string_lower(part, partLower);
+                if (LookupTop(partLower, maxEditDistance, top))
                 {
-                    topResult = results[0].term;
+                    topResult = top.term;
 
                     // v6.7
                     // retain/preserve upper case
@@ -881,8 +1546,8 @@ namespace symspellcpppy
                         topResult[0] = to_xupper(topResult[0]);
                     }
 
-                    topEd += results[0].distance;
-                    topProbabilityLog = log10((double)results[0].count / (double)N);
+                    topEd += top.distance;
+                    topProbabilityLog = log10((double)top.count / (double)N);
                 }
                 else
                 {
@@ -893,36 +1558,42 @@ namespace symspellcpppy
 
                 int destinationIndex = ((i + circularIndex) % arraySize);
 
+                if (j == 0)
+                {
+                    compositions[destinationIndex].set(part, topResult, topEd, topProbabilityLog);
+                    continue;
+                }
+
                 auto circular_distance = compositions[circularIndex].getDistance();
                 auto destination_distance = compositions[destinationIndex].getDistance();
                 auto circular_probablity = compositions[circularIndex].getProbability();
                 auto destination_probablity = compositions[destinationIndex].getProbability();
 
-                if (j == 0)
-                {
-                    compositions[destinationIndex].set(part, topResult, topEd, topProbabilityLog);
-                }
-                else if ((i == maxSegmentationWordLength) || (((circular_distance + topEd == destination_distance) || (circular_distance + separatorLength + topEd == destination_distance)) && (destination_probablity < circular_probablity + topProbabilityLog)) || (circular_distance + separatorLength + topEd < destination_distance))
+                if ((i == maxSegmentationWordLength) || (((circular_distance + topEd == destination_distance) || (circular_distance + separatorLength + topEd == destination_distance)) && (destination_probablity < circular_probablity + topProbabilityLog)) || (circular_distance + separatorLength + topEd < destination_distance))
                 {
+                    segmented = compositions[circularIndex].getSegmented();
+                    corrected = compositions[circularIndex].getCorrected();
                     // v6.7
                     // keep punctuation or spostrophe adjacent to previous word
                     if (((topResult.size() == 1) && (is_xpunct(topResult[0]) > 0)) || ((topResult.size() == 2) &&
                                                                                        (topResult.rfind(XL("’"), 0) ==
                                                                                         0)))
                     {
-                        xstring seg = compositions[circularIndex].getSegmented() + part;
-                        xstring correct = compositions[circularIndex].getCorrected() + topResult;
+                        segmented += part;
+                        corrected += topResult;
                         int d = circular_distance + topEd;
                         double prob = circular_probablity + topProbabilityLog;
-                        compositions[destinationIndex].set(seg, correct, d, prob);
+                        compositions[destinationIndex].set(segmented, corrected, d, prob);
                     }
                     else
                     {
-                        xstring seg = compositions[circularIndex].getSegmented() + XL(" ") + part;
-                        xstring correct = compositions[circularIndex].getCorrected() + XL(" ") + topResult;
+                        segmented += XL(' ');
+                        segmented += part;
+                        corrected += XL(' ');
+                        corrected += topResult;
                         int d = circular_distance + separatorLength + topEd;
                         double prob = circular_probablity + topProbabilityLog;
-                        compositions[destinationIndex].set(seg, correct, d, prob);
+                        compositions[destinationIndex].set(segmented, corrected, d, prob);
                     }
                 }
             }
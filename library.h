@@ -7,6 +7,11 @@
 #define DEFAULT_COUNT_THRESHOLD 1
 #define DEFAULT_INITIAL_CAPACITY 82765
 #define DEFAULT_COMPACT_LEVEL 5
+#define DEFAULT_BUILD_THREADS 1
+#define DEFAULT_LOOKUP_THREADS 0
+#define DEFAULT_LOOKUP_CACHE_SHARDS 16
+#define DEFAULT_TOP_K 5
+#define DEFAULT_DISTANCE_ALGORITHM DistanceAlgorithm::DamerauOSADistance
 #define min3(a, b, c) (min(a, min(b, c)))
 #define MAXINT LLONG_MAX
 #define M
@@ -23,8 +28,23 @@
 #include <iostream>
 #include "unordered_set"
 #include "include/Defines.h"
+#include "include/BitVectorDistance.h"
+#include "include/CharSignature.h"
+#include "include/DeleteEnumerator.h"
+#include "include/DictionaryParser.h"
 #include "include/Helpers.h"
 #include "include/EditDistance.h"
+#include "include/FrozenIndex.h"
+#include "include/LookupCache.h"
+#include "include/LookupContext.h"
+#include "include/LookupStats.h"
+#include "include/MappedFile.h"
+#include "include/PerfectHash.h"
+#include "include/PostingCodec.h"
+#include "include/PostingList.h"
+#include "include/Snapshot.h"
+#include "include/TermArena.h"
+#include "include/WordInfo.h"
 #include "cereal/types/unordered_map.hpp"
 #include "cereal/types/string.hpp"
 #include "cereal/types/vector.hpp"
@@ -65,24 +85,24 @@ namespace symspellcpppy
     private:
         xstring segmentedstring;
         xstring correctedstring;
-        int distanceSum;
-        double probabilityLogSum;
+        int distanceSum = 0;
+        double probabilityLogSum = 0;
 
     public:
-        void set(xstring &seg, xstring &cor, int d, double prob)
+        void set(xstring_view seg, xstring_view cor, int d, double prob)
         {
-            segmentedstring = seg;
-            correctedstring = cor;
+            segmentedstring.assign(seg.begin(), seg.end());
+            correctedstring.assign(cor.begin(), cor.end());
             distanceSum = d;
             probabilityLogSum = prob;
         };
 
-        xstring getSegmented() const
+        const xstring &getSegmented() const
         {
             return segmentedstring;
         };
 
-        xstring getCorrected() const
+        const xstring &getCorrected() const
         {
             return correctedstring;
         };
@@ -98,6 +118,32 @@ namespace symspellcpppy
         };
     };
 
+    /// <summary>Suggestions for a batch of input words, kept in flat arrays instead of one vector per word.</summary>
+    /// <remarks>Repeated input words share one run of suggestions: the suggestions of input word i are
+    /// suggestions[offsets[slots[i]], offsets[slots[i] + 1]).</remarks>
+    class SuggestionBatch
+    {
+    public:
+        std::vector<SuggestItem> suggestions;
+        std::vector<size_t> offsets{0}; // start of the suggestions of every distinct input word, then the end
+        std::vector<uint32_t> slots;    // distinct input word of every input word
+
+        size_t Size() const
+        {
+            return slots.size();
+        }
+
+        const SuggestItem *Begin(size_t index) const
+        {
+            return suggestions.data() + offsets[slots[index]];
+        }
+
+        const SuggestItem *End(size_t index) const
+        {
+            return suggestions.data() + offsets[slots[index] + 1];
+        }
+    };
+
     /// <summary>Controls the closeness/quantity of returned spelling suggestions.</summary>
     enum Verbosity
     {
@@ -107,9 +153,17 @@ namespace symspellcpppy
         Closest,
         /// <summary>All suggestions within maxEditDistance, suggestions ordered by edit distance
         /// , then by term frequency (slower, no early termination).</summary>
-        All
+        All,
+        /// <summary>The first k suggestions All would return. The search stops going deeper once k suggestions
+        /// are found that deeper candidates can't beat.</summary>
+        TopK
     };
 
+    /// <summary>Symmetric delete spelling correction over a dictionary of words and their counts.</summary>
+    /// <remarks>The query methods (Lookup, LookupCompound, WordSegmentation and the const accessors) only read the
+    /// dictionary and take no locks, any number of threads can query one instance at the same time. Methods that
+    /// modify the dictionary (creating, deleting or loading entries, Freeze, LoadSnapshot) must not run
+    /// concurrently with anything else on the same instance.</remarks>
     class SymSpell
     {
     protected:
@@ -118,11 +172,23 @@ namespace symspellcpppy
         int prefixLength;    // prefix length  5..7
         long countThreshold; // a threshold might be specified, when a term occurs so frequently in the corpus that it is considered a valid word for spelling correction
         int compactMask;
-        DistanceAlgorithm distanceAlgorithm = DistanceAlgorithm::DamerauOSADistance;
+        PostingCodec postingCodec; // the codec Freeze uses, following the compact level
+        DistanceAlgorithm distanceAlgorithm;
         int maxDictionaryWordLength; // maximum std::unordered_map term length
-        std::shared_ptr<std::unordered_map<int, std::vector<xstring>>> deletes;
-        std::unordered_map<xstring, int64_t> words;
+        std::shared_ptr<std::unordered_map<int, PostingList>> deletes; // delete hash -> word ids
+        TermArena terms;                  // every dictionary word, addressed by its id
+        FlatArray<int64_t> wordCounts;    // count of each word id, -1 once the word has been deleted
+        FlatArray<WordInfo> wordInfos;    // what lookups screen each word id by, see WordInfo
+        FlatArray<uint32_t> wordLengthStarts; // once frozen, the first word id of every length, ids are sorted by length then
+        int wordCount = 0;
+        std::shared_ptr<MappedFile> snapshot; // keeps a loaded snapshot mapped while the index points into it
         std::unordered_map<xstring, int64_t> belowThresholdWords;
+        FrozenIndex frozenIndex;
+        TermArena frozenBigrams;          // the bigrams once frozen, the bigrams map is emptied then
+        FlatArray<int64_t> frozenBigramCounts;
+        bool frozen = false;
+        std::shared_ptr<LookupCache> lookupCache; // null unless enabled
+        mutable LookupCounters lookupCounters;
 
     public:
         int MaxDictionaryEditDistance() const;
@@ -133,9 +199,11 @@ namespace symspellcpppy
 
         long CountThreshold() const;
 
-        int WordCount();
+        int WordCount() const;
 
-        int EntryCount();
+        int EntryCount() const;
+
+        DistanceAlgorithm GetDistanceAlgorithm() const;
 
         /// <summary>Create a new instanc of SymSpell.</summary>
         /// <remarks>Specifying ann accurate initialCapacity is not essential,
@@ -146,10 +214,12 @@ namespace symspellcpppy
         /// <param name="prefixLength">The length of word prefixes used for spell checking..</param>
         /// <param name="countThreshold">The minimum frequency count for dictionary words to be considered correct spellings.</param>
         /// <param name="compactLevel">Degree of favoring lower memory use over speed (0=fastest,most memory, 16=slowest,least memory).</param>
+        /// <param name="distanceAlgorithm">The edit distance used to verify suggestions.</param>
         explicit SymSpell(int maxDictionaryEditDistance = DEFAULT_MAX_EDIT_DISTANCE,
                           int prefixLength = DEFAULT_PREFIX_LENGTH, int countThreshold = DEFAULT_COUNT_THRESHOLD,
                           int initialCapacity = DEFAULT_INITIAL_CAPACITY,
-                          unsigned char compactLevel = DEFAULT_COMPACT_LEVEL);
+                          unsigned char compactLevel = DEFAULT_COMPACT_LEVEL,
+                          DistanceAlgorithm distanceAlgorithm = DEFAULT_DISTANCE_ALGORITHM);
 
         bool CreateDictionaryEntry(const xstring &key, int64_t count, const std::shared_ptr<SuggestionStage> &staging);
 
@@ -177,20 +247,23 @@ namespace symspellcpppy
         /// <param name="termIndex">The column position of the word.</param>
         /// <param name="countIndex">The column position of the frequency count.</param>
         /// <param name="separatorChars">Separator characters between term(s) and count.</param>
+        /// <param name="threads">Number of threads generating the deletes, 0 for one per hardware thread.
+        /// The resulting index is identical whatever the thread count.</param>
         /// <returns>True if file loaded, or false if file not found.</returns>
         bool LoadDictionary(const std::string &corpus, int termIndex, int countIndex,
-                            xchar separatorChars = DEFAULT_SEPARATOR_CHAR);
+                            xchar separatorChars = DEFAULT_SEPARATOR_CHAR, int threads = DEFAULT_BUILD_THREADS);
 
         bool LoadDictionary(xifstream &corpusStream, int termIndex, int countIndex,
-                            xchar separatorChars = DEFAULT_SEPARATOR_CHAR);
+                            xchar separatorChars = DEFAULT_SEPARATOR_CHAR, int threads = DEFAULT_BUILD_THREADS);
 
         /// <summary>Load multiple dictionary words from a file containing plain text.</summary>
         /// <remarks>Merges with any dictionary data already loaded.</remarks>
         /// <param name="corpus">The path+filename of the file.</param>
+        /// <param name="threads">Number of threads generating the deletes, 0 for one per hardware thread.</param>
         /// <returns>True if file loaded, or false if file not found.</returns>
-        bool CreateDictionary(const std::string &corpus);
+        bool CreateDictionary(const std::string &corpus, int threads = DEFAULT_BUILD_THREADS);
 
-        bool CreateDictionary(xifstream &corpusStream);
+        bool CreateDictionary(xifstream &corpusStream, int threads = DEFAULT_BUILD_THREADS);
 
         /// <summary>Remove all below threshold words from the dictionary.</summary>
         /// <remarks>This can be used to reduce memory consumption after populating the dictionary from
@@ -199,13 +272,46 @@ namespace symspellcpppy
 
         void CommitStaged(const std::shared_ptr<SuggestionStage> &staging);
 
+        /// <summary>Compile the dictionary into its compact read-only form.</summary>
+        /// <remarks>The delete buckets become contiguous runs of word ids in a single postings array and the
+        /// bigrams move into a term arena, which needs far less memory than the build-time maps. Words, bigrams and
+        /// delete buckets are found through minimal perfect hashes from then on. The maps and the
+        /// words below the count threshold are dropped. Words can't be added or deleted afterwards, bigrams loaded
+        /// afterwards are kept in a map of their own. The postings are stored with the codec of the compact level:
+        /// uncompressed up to the default level, StreamVByte up to 10 and varints above.</remarks>
+        void Freeze();
+
+        /// <summary>Compile the dictionary into its compact read-only form, storing the postings with a given
+        /// codec.</summary>
+        /// <remarks>Compressed postings take a fraction of the memory and are decoded bucket by bucket during
+        /// lookups, which makes lookups slower.</remarks>
+        void Freeze(PostingCodec codec);
+
+        bool IsFrozen() const;
+
+        /// <summary>The codec of the postings, the one Freeze will use if the dictionary isn't frozen yet.</summary>
+        PostingCodec GetPostingCodec() const;
+
+        /// <summary>Save the frozen dictionary as a memory-mappable snapshot.</summary>
+        /// <remarks>The dictionary is frozen first if it isn't already, the bigrams are part of the snapshot.</remarks>
+        /// <param name="path">The path+filename of the snapshot file.</param>
+        void SaveSnapshot(const std::string &path);
+
+        /// <summary>Replace the dictionary with a snapshot written by SaveSnapshot.</summary>
+        /// <remarks>The file is mapped read-only and used in place without deserialization, so loading takes
+        /// constant time and processes mapping the same snapshot share its memory through the page cache.
+        /// The edit distance, prefix length and compact level of the snapshot replace the ones of this instance,
+        /// and the dictionary is frozen afterwards.</remarks>
+        /// <param name="path">The path+filename of the snapshot file.</param>
+        void LoadSnapshot(const std::string &path);
+
         /// <summary>Find suggested spellings for a given input word, using the maximum
         /// edit distance specified during construction of the SymSpell dictionary.</summary>
         /// <param name="input">The word being spell checked.</param>
         /// <param name="verbosity">The value controlling the quantity/closeness of the retuned suggestions.</param>
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input word,
         /// sorted by edit distance, and secondarily by count frequency.</returns>
-        std::vector<SuggestItem> Lookup(const xstring &input, Verbosity verbosity);
+        std::vector<SuggestItem> Lookup(xstring_view input, Verbosity verbosity) const;
 
         /// <summary>Find suggested spellings for a given input word, using the maximum
         /// edit distance specified during construction of the SymSpell dictionary.</summary>
@@ -214,7 +320,7 @@ namespace symspellcpppy
         /// <param name="maxEditDistance">The maximum edit distance between input and suggested words.</param>
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input word,
         /// sorted by edit distance, and secondarily by count frequency.</returns>
-        std::vector<SuggestItem> Lookup(const xstring &input, Verbosity verbosity, int maxEditDistance);
+        std::vector<SuggestItem> Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance) const;
 
         /// <summary>Find suggested spellings for a given input word.</summary>
         /// <param name="input">The word being spell checked.</param>
@@ -223,7 +329,7 @@ namespace symspellcpppy
         /// <param name="includeUnknown">Include input word in suggestions, if no words within edit distance found.</param>
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input word,
         /// sorted by edit distance, and secondarily by count frequency.</returns>
-        std::vector<SuggestItem> Lookup(const xstring &input, Verbosity verbosity, int maxEditDistance, bool includeUnknown);
+        std::vector<SuggestItem> Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown) const;
 
         /// <summary>Find suggested spellings for a given input word.</summary>
         /// <param name="input">The word being spell checked.</param>
@@ -233,20 +339,139 @@ namespace symspellcpppy
         /// <param name="transfer_casing"> Lower case the word or not
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input word,
         /// sorted by edit distance, and secondarily by count frequency.</returns>
-        std::vector<SuggestItem> Lookup(const xstring &input, Verbosity verbosity, int maxEditDistance, bool includeUnknown, bool transferCasing);
+        std::vector<SuggestItem> Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown, bool transferCasing) const;
+
+        /// <summary>Find suggested spellings for a given input word.</summary>
+        /// <param name="input">The word being spell checked.</param>
+        /// <param name="verbosity">The value controlling the quantity/closeness of the retuned suggestions.</param>
+        /// <param name="maxEditDistance">The maximum edit distance between input and suggested words.</param>
+        /// <param name="includeUnknown">Include input word in suggestions, if no words within edit distance found.</param>
+        /// <param name="transferCasing">Lower case the word or not.</param>
+        /// <param name="k">Number of suggestions returned with the TopK verbosity, ignored otherwise.</param>
+        /// <returns>A List of SuggestItem object representing suggested correct spellings for the input word,
+        /// sorted by edit distance, and secondarily by count frequency.</returns>
+        std::vector<SuggestItem> Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance, bool includeUnknown,
+                                        bool transferCasing, int k) const;
+
+        /// <summary>Find suggested spellings for a given input word, in the caller's scratch storage.</summary>
+        /// <remarks>The other Lookup overloads use a context of the calling thread and hand its suggestions to the
+        /// caller, so every call allocates a new vector for them. Reusing a context spares that, and a lookup then
+        /// only allocates while the context's buffers are still growing.</remarks>
+        /// <param name="input">The word being spell checked.</param>
+        /// <param name="verbosity">The value controlling the quantity/closeness of the retuned suggestions.</param>
+        /// <param name="maxEditDistance">The maximum edit distance between input and suggested words.</param>
+        /// <param name="includeUnknown">Include input word in suggestions, if no words within edit distance found.</param>
+        /// <param name="transferCasing">Lower case the word or not.</param>
+        /// <param name="context">The scratch storage of the lookup, used by one lookup at a time.</param>
+        /// <param name="k">Number of suggestions returned with the TopK verbosity, ignored otherwise.</param>
+        /// <returns>The suggestions held by the context, sorted by edit distance, and secondarily by count
+        /// frequency. They stay valid until the next lookup with the same context.</returns>
+        const std::vector<SuggestItem> &Lookup(xstring_view input, Verbosity verbosity, int maxEditDistance,
+                                               bool includeUnknown, bool transferCasing, LookupContext &context,
+                                               int k = DEFAULT_TOP_K) const;
+
+        /// <summary>Find suggested spellings for many input words at once.</summary>
+        /// <remarks>Every distinct word is looked up once, however often it occurs in the batch,
+        /// and the lookups are spread over several threads.</remarks>
+        /// <param name="inputs">The words being spell checked, they are only read during the call.</param>
+        /// <param name="verbosity">The value controlling the quantity/closeness of the retuned suggestions.</param>
+        /// <param name="maxEditDistance">The maximum edit distance between input and suggested words.</param>
+        /// <param name="threads">Number of threads doing the lookups, 0 for one per hardware thread.</param>
+        /// <param name="includeUnknown">Include input word in suggestions, if no words within edit distance found.</param>
+        /// <param name="k">Number of suggestions per word with the TopK verbosity, ignored otherwise.</param>
+        /// <returns>The suggestions of every input word, in the order and sorting Lookup returns them.</returns>
+        SuggestionBatch LookupBatch(const std::vector<xstring_view> &inputs, Verbosity verbosity, int maxEditDistance,
+                                    int threads = DEFAULT_LOOKUP_THREADS, bool includeUnknown = false,
+                                    int k = DEFAULT_TOP_K) const;
+
+        /// <summary>Cache the results of Lookup, so repeated queries skip the candidate search.</summary>
+        /// <remarks>The cache is shared by all threads and only admits results asked for often enough (W-TinyLFU).
+        /// It is emptied whenever the dictionary changes. Enabling the cache again replaces it and its
+        /// statistics, a memoryBudget of 0 disables it.</remarks>
+        /// <param name="memoryBudget">Approximate number of bytes the cached results may take.</param>
+        /// <param name="shards">Number of independently locked parts of the cache.</param>
+        void EnableLookupCache(size_t memoryBudget, int shards = DEFAULT_LOOKUP_CACHE_SHARDS);
+
+        /// <summary>Hits, misses and size of the lookup cache, all zero when it isn't enabled.</summary>
+        LookupCache::Stats LookupCacheStats() const;
+
+        /// <summary>Drop the cached lookup results, the dictionary methods do this whenever they change it.</summary>
+        void ClearLookupCache();
+
+        /// <summary>Work done by the lookups since the instance was created or ResetLookupStats was called,
+        /// summed over all threads.</summary>
+        /// <remarks>The share of signatureRejections in signatureRejections + distanceComputations is the share
+        /// of edit distance computations the character signatures saved.</remarks>
+        LookupStats GetLookupStats() const;
+
+        void ResetLookupStats();
 
     private:
         bool
-        DeleteInSuggestionPrefix(const xstring &deleteSugg, int deleteLen, xstring suggestion, int suggestionLen) const;
+        DeleteInSuggestionPrefix(xstring_view deleteSugg, int deleteLen, xstring_view suggestion, int suggestionLen) const;
+
+        /// <summary>The codec Freeze uses for a compact level.</summary>
+        static PostingCodec PostingCodecOf(int compactLevel);
+
+        /// <summary>Find the words of a lower case text.</summary>
+        /// <param name="words">Receives views of the words into text.</param>
+        static void ParseWords(const xstring &text, std::vector<xstring_view> &words);
+
+        /// <summary>Lookup with the Top verbosity in the scratch storage of the calling thread.</summary>
+        /// <returns>False if there is no suggestion, best is left untouched then.</returns>
+        bool LookupTop(xstring_view input, int maxEditDistance, SuggestItem &best) const;
+
+        /// <summary>Enumerate the deletes of a dictionary word's prefix into the enumerator.</summary>
+        void EditsPrefix(xstring_view key, DeleteEnumerator &edits) const;
+
+        /// <summary>Add a count to a dictionary entry.</summary>
+        /// <returns>The id of the word if it just became a dictionary word and needs its deletes, otherwise npos.</returns>
+        uint32_t CountDictionaryEntry(xstring_view key, int64_t count);
+
+        /// <summary>Throw std::invalid_argument unless a pickle has the current layout.</summary>
+        static void CheckPickleVersion(uint32_t version);
 
-        static std::vector<xstring> ParseWords(const xstring &text);
+        /// <summary>The first word id of a frozen dictionary with at least a given length.</summary>
+        uint32_t FirstIdOfLength(int length) const;
 
-        std::shared_ptr<std::unordered_set<xstring>>
-        Edits(const xstring &word, int editDistance, std::shared_ptr<std::unordered_set<xstring>> deleteWords);
+        /// <summary>Set the count of a word id, and its WordInfo along with it.</summary>
+        void SetWordCount(uint32_t wordId, int64_t count);
 
-        std::shared_ptr<std::unordered_set<xstring>> EditsPrefix(const xstring &key);
+        /// <summary>Count the word of one line of a frequency dictionary.</summary>
+        void LoadDictionaryLine(xstring_view line, int termIndex, int countIndex, xchar separatorChars,
+                                std::vector<xstring_view> &columns, std::vector<uint32_t> &wordIds);
 
-        int GetstringHash(const xstring &s) const;
+        /// <summary>Add the bigram of one line of a bigram dictionary.</summary>
+        void LoadBigramDictionaryLine(xstring_view line, int termIndex, int countIndex, xchar separatorChars,
+                                      std::vector<xstring_view> &columns);
+
+        /// <summary>Generate the deletes of newly added words on several threads and merge them into the index,
+        /// in the same order a single staging pass over the words would have.</summary>
+        void CommitDeletes(const std::vector<uint32_t> &wordIds, int threads);
+
+        int GetstringHash(const DeleteEnumerator::Delete &edit) const;
+
+        /// <returns>False if the bigram isn't in the dictionary.</returns>
+        bool FindBigram(const xstring &bigram, int64_t &count) const;
+
+        /// <summary>Lookup with the distance algorithm fixed at compile time, Lookup picks the instantiation.</summary>
+        /// <remarks>The suggestions are left in context.suggestions.</remarks>
+        /// <param name="inputId">Dictionary id of the input, or npos. With transferCasing the lower case input
+        /// is looked up instead.</param>
+        template <class DistancePolicy>
+        void LookupWith(xstring_view input, uint32_t inputId, Verbosity verbosity, int maxEditDistance,
+                        bool includeUnknown, bool transferCasing, int k, LookupContext &context) const;
+
+        /// <summary>Answer a lookup from the input's own dictionary entry, with the verbosities that stop
+        /// searching at an exact match.</summary>
+        /// <param name="inputId">Receives the dictionary id of the input, or npos.</param>
+        /// <returns>True if suggestions holds the answer, false if the lookup needs the candidate search.</returns>
+        bool LookupKnownWord(xstring_view input, Verbosity verbosity, int maxEditDistance, int k, uint32_t &inputId,
+                             std::vector<SuggestItem> &suggestions) const;
+
+        /// <summary>Edit distance between two strings with the distance algorithm of this instance.</summary>
+        /// <returns>The distance, or -1 if it is larger than maxDistance.</returns>
+        int Distance(xstring_view string1, xstring_view string2, int maxDistance) const;
 
     public:
         // ######################
@@ -259,19 +484,19 @@ namespace symspellcpppy
         /// <summary>Find suggested spellings for a multi-word input string (supports word splitting/merging).</summary>
         /// <param name="input">The string being spell checked.</param>
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input string.</returns>
-        std::vector<SuggestItem> LookupCompound(const xstring &input);
+        std::vector<SuggestItem> LookupCompound(xstring_view input) const;
 
         /// <summary>Find suggested spellings for a multi-word input string (supports word splitting/merging).</summary>
         /// <param name="input">The string being spell checked.</param>
         /// <param name="maxEditDistance">The maximum edit distance between input and suggested words.</param>
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input string.</returns>
-        std::vector<SuggestItem> LookupCompound(const xstring &input, int editDistanceMax);
+        std::vector<SuggestItem> LookupCompound(xstring_view input, int editDistanceMax) const;
 
         /// <summary>Find suggested spellings for a multi-word input string (supports word splitting/merging).</summary>
         /// <param name="input">The string being spell checked.</param>
         /// <param name="maxEditDistance">The maximum edit distance between input and suggested words.</param>
         /// <returns>A List of SuggestItem object representing suggested correct spellings for the input string.</returns>
-        std::vector<SuggestItem> LookupCompound(const xstring &input, int editDistanceMax, bool transferCasing);
+        std::vector<SuggestItem> LookupCompound(xstring_view input, int editDistanceMax, bool transferCasing) const;
 
         // ######
 
@@ -295,7 +520,7 @@ namespace symspellcpppy
         /// the word segmented and spelling corrected string,
         /// the Edit distance sum between input string and corrected string,
         /// the Sum of word occurrence probabilities in log scale (a measure of how common and probable the corrected segmentation is).</returns>
-        Info WordSegmentation(const xstring &input);
+        Info WordSegmentation(xstring_view input) const;
 
         /// <summary>Find suggested spellings for a multi-word input string (supports word splitting/merging).</summary>
         /// <param name="input">The string being spell checked.</param>
@@ -305,7 +530,7 @@ namespace symspellcpppy
         /// the word segmented and spelling corrected string,
         /// the Edit distance sum between input string and corrected string,
         /// the Sum of word occurrence probabilities in log scale (a measure of how common and probable the corrected segmentation is).</returns>
-        Info WordSegmentation(const xstring &input, int maxEditDistance);
+        Info WordSegmentation(xstring_view input, int maxEditDistance) const;
 
         /// <summary>Find suggested spellings for a multi-word input string (supports word splitting/merging).</summary>
         /// <param name="input">The string being spell checked.</param>
@@ -316,12 +541,61 @@ namespace symspellcpppy
         /// the word segmented and spelling corrected string,
         /// the Edit distance sum between input string and corrected string,
         /// the Sum of word occurrence probabilities in log scale (a measure of how common and probable the corrected segmentation is).</returns>
-        Info WordSegmentation(const xstring &input, int maxEditDistance, int maxSegmentationWordLength);
+        Info WordSegmentation(xstring_view input, int maxEditDistance, int maxSegmentationWordLength) const;
 
+        /// <summary>Version of the pickle layout written by save, load rejects every other version.</summary>
+        /// <remarks>1: the frozen index follows the delete index.
+        /// 2: word ids and a term arena replace the words map.
+        /// 3: the letter signatures of the words are saved.
+        /// 4: packed word infos and the first id of every length replace the signatures.
+        /// 5: the bigrams are saved, frozen or not.</remarks>
+        static constexpr uint32_t PickleVersion = 5;
+
+        template <class Archive>
+        void save(Archive &ar, const std::uint32_t) const
+        {
+            ar(deletes, terms, wordCounts, wordInfos, wordCount, maxDictionaryWordLength, frozen, frozenIndex, wordLengthStarts,
+               bigrams, frozenBigrams, frozenBigramCounts, bigramCountMin);
+        }
+
+        /// <remarks>The pickle is read into temporaries first, an unsupported or broken pickle leaves the
+        /// dictionary as it was. The lookup cache is emptied once the pickle replaced the dictionary.</remarks>
         template <class Archive>
-        void serialize(Archive &ar)
+        void load(Archive &ar, const std::uint32_t version)
         {
-            ar(deletes, words, maxDictionaryWordLength);
+            CheckPickleVersion(version);
+            std::shared_ptr<std::unordered_map<int, PostingList>> loadedDeletes;
+            TermArena loadedTerms;
+            FlatArray<int64_t> loadedCounts;
+            FlatArray<WordInfo> loadedInfos;
+            int loadedWordCount = 0;
+            int loadedMaxLength = 0;
+            bool loadedFrozen = false;
+            FrozenIndex loadedIndex;
+            FlatArray<uint32_t> loadedLengthStarts;
+            std::unordered_map<xstring, long> loadedBigrams;
+            TermArena loadedFrozenBigrams;
+            FlatArray<int64_t> loadedBigramCounts;
+            int64_t loadedBigramCountMin = MAXLONG;
+            ar(loadedDeletes, loadedTerms, loadedCounts, loadedInfos, loadedWordCount, loadedMaxLength, loadedFrozen,
+               loadedIndex, loadedLengthStarts, loadedBigrams, loadedFrozenBigrams, loadedBigramCounts, loadedBigramCountMin);
+
+            deletes = std::move(loadedDeletes);
+            terms = std::move(loadedTerms);
+            wordCounts = std::move(loadedCounts);
+            wordInfos = std::move(loadedInfos);
+            wordCount = loadedWordCount;
+            maxDictionaryWordLength = loadedMaxLength;
+            frozen = loadedFrozen;
+            frozenIndex = std::move(loadedIndex);
+            wordLengthStarts = std::move(loadedLengthStarts);
+            bigrams = std::move(loadedBigrams);
+            frozenBigrams = std::move(loadedFrozenBigrams);
+            frozenBigramCounts = std::move(loadedBigramCounts);
+            bigramCountMin = loadedBigramCountMin;
+            ClearLookupCache();
         }
     };
 }
+
+CEREAL_CLASS_VERSION(symspellcpppy::SymSpell, symspellcpppy::SymSpell::PickleVersion)
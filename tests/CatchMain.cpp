@@ -2,9 +2,53 @@
 
 #include "catch2/catch.hpp"
 #include "../library.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+// every heap allocation of the test binary is counted, so tests can check a code path doesn't allocate
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(std::size_t size)
+{
+    allocationCount++;
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
 
 using namespace symspellcpppy;
 
+// the first n misspelled words of the noisy query corpus
+static std::vector<xstring> ReadQueries(size_t n)
+{
+    std::vector<xstring> queries;
+    xifstream queryStream("../tests/fortests/noisy_query_en_1000.txt");
+    xstring line;
+    while (queries.size() < n && getline(queryStream, line))
+        queries.push_back(line.substr(0, line.find(XL(' '))));
+    return queries;
+}
+
+static bool SameSuggestions(const std::vector<SuggestItem> &a, const std::vector<SuggestItem> &b)
+{
+    bool same = a.size() == b.size();
+    for (size_t k = 0; same && k < a.size(); k++)
+        same = a[k].Equals(b[k]);
+    return same;
+}
+
 TEST_CASE("Testing English", "[english]")
 {
     const int maxEditDistance = 2;
@@ -197,4 +241,867 @@ TEST_CASE("Testing English", "[english]")
         auto results = symSpell.Lookup(typo, Verbosity::Top, 2, false, true);
         REQUIRE(results[0].term == correction);
     }
-}
\ No newline at end of file
+
+    SECTION("Frozen index gives the same suggestions")
+    {
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        SymSpell frozenSymSpell(maxEditDistance, prefixLength);
+        frozenSymSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        frozenSymSpell.Freeze();
+        REQUIRE(frozenSymSpell.IsFrozen());
+        REQUIRE(frozenSymSpell.EntryCount() == symSpell.EntryCount());
+
+        for (xstring_view word : {XL("tke"), XL("abolution"), XL("intermedaite"), XL("extrine"), XL("elipnaht")})
+        {
+            for (auto verbosity : {Verbosity::Top, Verbosity::Closest, Verbosity::All, Verbosity::TopK})
+            {
+                auto expected = symSpell.Lookup(word, verbosity, 2);
+                auto results = frozenSymSpell.Lookup(word, verbosity, 2);
+                REQUIRE(results.size() == expected.size());
+                for (int i = 0; i < results.size(); i++)
+                    REQUIRE(results[i].Equals(expected[i]));
+            }
+        }
+        REQUIRE_THROWS_AS(frozenSymSpell.DeleteDictionaryEntry(XL("the")), std::logic_error);
+    }
+
+    SECTION("Deleted words can be added again")
+    {
+        SymSpell symSpellcustom(maxEditDistance, prefixLength);
+        auto staging = std::make_shared<SuggestionStage>(100);
+        symSpellcustom.CreateDictionaryEntry(XL("steama"), 4, staging);
+        symSpellcustom.CreateDictionaryEntry(XL("steamb"), 6, staging);
+        symSpellcustom.CommitStaged(staging);
+        REQUIRE(symSpellcustom.DeleteDictionaryEntry(XL("steamb")));
+        REQUIRE(symSpellcustom.WordCount() == 1);
+        auto results = symSpellcustom.Lookup(XL("steamc"), Verbosity::All, 2);
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].term == XL("steama"));
+
+        symSpellcustom.CreateDictionaryEntry(XL("steamb"), 2, nullptr);
+        REQUIRE(symSpellcustom.WordCount() == 2);
+        results = symSpellcustom.Lookup(XL("steamc"), Verbosity::All, 2);
+        REQUIRE(results.size() == 2);
+        REQUIRE(results[0].term == XL("steama"));
+        REQUIRE(results[1].term == XL("steamb"));
+        REQUIRE(results[1].count == 2);
+    }
+
+    SECTION("Snapshot gives the same suggestions")
+    {
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        auto filepath = "../resources/model.snapshot";
+        symSpell.SaveSnapshot(filepath);
+        REQUIRE(symSpell.IsFrozen());
+
+        SymSpell snapshotSymSpell;
+        snapshotSymSpell.LoadSnapshot(filepath);
+        REQUIRE(snapshotSymSpell.IsFrozen());
+        REQUIRE(snapshotSymSpell.PrefixLength() == prefixLength);
+        REQUIRE(snapshotSymSpell.WordCount() == symSpell.WordCount());
+        REQUIRE(snapshotSymSpell.EntryCount() == symSpell.EntryCount());
+        REQUIRE(snapshotSymSpell.MaxLength() == symSpell.MaxLength());
+
+        for (xstring_view word : {XL("tke"), XL("abolution"), XL("intermedaite"), XL("the"), XL("elipnaht")})
+        {
+            for (auto verbosity : {Verbosity::Top, Verbosity::Closest, Verbosity::All})
+            {
+                auto expected = symSpell.Lookup(word, verbosity, 2);
+                auto results = snapshotSymSpell.Lookup(word, verbosity, 2);
+                REQUIRE(results.size() == expected.size());
+                for (int i = 0; i < results.size(); i++)
+                    REQUIRE(results[i].Equals(expected[i]));
+            }
+        }
+        REQUIRE(snapshotSymSpell.WordSegmentation(XL("thequickbrownfox")).getCorrected() == XL("the quick brown fox"));
+
+        for (int32_t editDistance : {-1, prefixLength})
+        {
+            std::fstream file(filepath, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(offsetof(SnapshotHeader, maxDictionaryEditDistance));
+            file.write(reinterpret_cast<const char *>(&editDistance), sizeof(editDistance));
+            file.close();
+            SymSpell corruptSymSpell;
+            REQUIRE_THROWS_WITH(corruptSymSpell.LoadSnapshot(filepath), Catch::Contains("invalid max edit distance"));
+        }
+        std::remove(filepath);
+
+        SymSpell notASnapshot;
+        REQUIRE_THROWS_AS(notASnapshot.LoadSnapshot("../resources/frequency_dictionary_en_test_verbosity.txt"),
+                          std::invalid_argument);
+    }
+
+    SECTION("Delete enumerator lists every delete once")
+    {
+        xstring word = XL("aab");
+        DeleteEnumerator edits;
+        edits.Reset(word);
+        for (size_t i = 0; i < edits.Size(); i++)
+        {
+            if (edits.RemovedCount(edits[i]) < 2)
+                edits.AddDeletes(i);
+        }
+        edits.Add(edits.EmptyMask()); // already there
+
+        std::vector<xstring> expected = {XL("aab"), XL("ab"), XL("aa"), XL("b"), XL("a"), XL("")};
+        REQUIRE(edits.Size() == expected.size());
+        xstring edit;
+        for (size_t i = 0; i < edits.Size(); i++)
+        {
+            edits.Materialize(edits[i], edit);
+            REQUIRE(edit == expected[i]);
+            REQUIRE(edits[i].length == (int)edit.size());
+            uint32_t hash = 2166136261u;
+            for (xchar c : edit)
+                hash = (hash ^ (uint32_t)c) * 16777619u;
+            REQUIRE(edits[i].hash == hash);
+        }
+    }
+
+    SECTION("Mapped and streamed dictionaries parse the same")
+    {
+        auto filepath = "../resources/parser_test.txt";
+        {
+            std::ofstream out(filepath, std::ios::binary);
+            out << "apple 10\nbanana\ncherry x\nplum 5 extra\ntail 3";
+        }
+        SymSpell mapped(maxEditDistance, prefixLength);
+        REQUIRE(mapped.LoadDictionary(filepath, 0, 1, XL(' ')));
+        SymSpell streamed(maxEditDistance, prefixLength);
+        xifstream corpusStream(filepath);
+        REQUIRE(streamed.LoadDictionary(corpusStream, 0, 1, XL(' ')));
+        std::remove(filepath);
+
+        std::vector<std::pair<xstring, int64_t>> expected = {
+            {XL("apple"), 10}, {XL("banana"), 1}, {XL("cherry"), 1}, {XL("plum"), 5}, {XL("tail"), 3}};
+        for (SymSpell *symSpell : {&mapped, &streamed})
+        {
+            REQUIRE(symSpell->WordCount() == expected.size());
+            for (const auto &entry : expected)
+            {
+                auto results = symSpell->Lookup(entry.first, Verbosity::Top, 0);
+                REQUIRE(results.size() == 1);
+                REQUIRE(results[0].count == entry.second);
+            }
+        }
+        REQUIRE_FALSE(mapped.LoadDictionary("../resources/missing_dictionary.txt", 0, 1, XL(' ')));
+    }
+
+    SECTION("Concurrent queries on one instance")
+    {
+        std::vector<xstring> queries = ReadQueries(200);
+        REQUIRE(queries.size() == 200);
+
+        struct Answer
+        {
+            std::vector<SuggestItem> lookup;
+            xstring compound;
+            xstring segmented;
+        };
+        for (bool freeze : {false, true})
+        {
+            SymSpell symSpell(maxEditDistance, 7);
+            symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+            if (freeze)
+                symSpell.Freeze();
+            const SymSpell &shared = symSpell;
+            auto answer = [&shared](const xstring &query)
+            {
+                return Answer{shared.Lookup(query, Verbosity::All, 2),
+                              shared.LookupCompound(query)[0].term,
+                              shared.WordSegmentation(query).getCorrected()};
+            };
+            std::vector<Answer> expected;
+            for (const auto &query : queries)
+                expected.push_back(answer(query));
+
+            // every thread walks all the queries from a different starting point
+            const int threadCount = 4;
+            std::atomic<int> mismatches{0};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < threadCount; t++)
+            {
+                threads.emplace_back([&, t]()
+                                     {
+                    for (size_t n = 0; n < queries.size(); n++)
+                    {
+                        size_t i = (n + t * queries.size() / threadCount) % queries.size();
+                        Answer result = answer(queries[i]);
+                        if (!SameSuggestions(result.lookup, expected[i].lookup) ||
+                            result.compound != expected[i].compound || result.segmented != expected[i].segmented)
+                            mismatches++;
+                    } });
+            }
+            for (auto &thread : threads)
+                thread.join();
+            REQUIRE(mismatches == 0);
+        }
+    }
+
+    SECTION("Parallel build gives the same index")
+    {
+        auto readFile = [](const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        };
+        std::vector<std::string> snapshots;
+        for (int threads : {1, 4, 0})
+        {
+            SymSpell symSpell(maxEditDistance, prefixLength);
+            // deletes already in the index must stay ahead of the merged ones
+            symSpell.CreateDictionaryEntry(XL("steama"), 4, nullptr);
+            symSpell.CreateDictionaryEntry(XL("steamb"), 6, nullptr);
+            REQUIRE(symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '), threads));
+            auto filepath = "../resources/model_" + std::to_string(threads) + ".snapshot";
+            symSpell.SaveSnapshot(filepath);
+            snapshots.push_back(readFile(filepath));
+            std::remove(filepath.c_str());
+        }
+        REQUIRE(!snapshots[0].empty());
+        REQUIRE(snapshots[1] == snapshots[0]);
+        REQUIRE(snapshots[2] == snapshots[0]);
+
+        SymSpell symSpell;
+        REQUIRE_THROWS_AS(symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '), -1),
+                          std::invalid_argument);
+    }
+
+    SECTION("Batch lookup matches single lookups")
+    {
+        std::vector<xstring> queries = ReadQueries(300);
+        // repeated words share their suggestions
+        for (size_t i = 0; i < 100; i++)
+            queries.push_back(queries[i * 3]);
+        std::vector<xstring_view> inputs(queries.begin(), queries.end());
+
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        for (int threads : {1, 4})
+        {
+            SuggestionBatch batch = symSpell.LookupBatch(inputs, Verbosity::Closest, 2, threads, true);
+            REQUIRE(batch.Size() == queries.size());
+            REQUIRE(batch.offsets.size() == 301);
+            int mismatches = 0;
+            for (size_t i = 0; i < queries.size(); i++)
+            {
+                std::vector<SuggestItem> expected = symSpell.Lookup(queries[i], Verbosity::Closest, 2, true);
+                if (!SameSuggestions(std::vector<SuggestItem>(batch.Begin(i), batch.End(i)), expected))
+                    mismatches++;
+            }
+            REQUIRE(mismatches == 0);
+        }
+        REQUIRE(symSpell.LookupBatch({}, Verbosity::Top, 2).Size() == 0);
+        REQUIRE_THROWS_AS(symSpell.LookupBatch(inputs, Verbosity::Top, 3), std::invalid_argument);
+    }
+
+    SECTION("Bit-parallel distances match the dynamic programming ones")
+    {
+        std::vector<std::pair<xstring, xstring>> pairs = {
+            {XL("abcd"), XL("acbd")}, {XL("ca"), XL("abc")}, {XL("kitten"), XL("sitting")},
+            {XL("steam"), XL("steem")}, {XL("abolution"), XL("absolution")}, {XL("ab"), XL("ba")}};
+        // words at the limit of the kernels, and beyond it where the dynamic programming takes over
+        xstring longWord;
+        for (int i = 0; i < 66; i++)
+            longWord.push_back((xchar)(XL('a') + (i * 7) % 5));
+        for (size_t length : {63, 64, 65, 66})
+        {
+            xstring word = longWord.substr(0, length);
+            xstring typo = word;
+            std::swap(typo[1], typo[2]);
+            typo.erase(30, 1);
+            typo[50] = XL('z');
+            pairs.emplace_back(word, typo);
+            pairs.emplace_back(XL("x") + word + XL("y"), XL("y") + typo + XL("x"));
+        }
+
+        DamerauOSA osa;
+        Levenshtein levenshtein;
+        for (const auto &pair : pairs)
+        {
+            xstring_view str1 = pair.first.size() > pair.second.size() ? pair.second : pair.first;
+            xstring_view str2 = pair.first.size() > pair.second.size() ? pair.first : pair.second;
+            int len1, len2, start;
+            Helpers::PrefixSuffixPrep(str1, str2, len1, len2, start);
+            std::vector<int> costs(len2), prevCosts(len2);
+            int expectedOsa = len2, expectedLevenshtein = len2;
+            if (len1 != 0)
+            {
+                expectedOsa = DamerauOSA::Distance(str1, str2, len1, len2, start, costs, prevCosts);
+                expectedLevenshtein = Levenshtein::Distance(str1, str2, len1, len2, start, costs);
+            }
+            REQUIRE(osa.Distance(pair.first, pair.second) == expectedOsa);
+            REQUIRE(levenshtein.Distance(pair.first, pair.second) == expectedLevenshtein);
+            for (int maxDistance : {1, 2, 3})
+            {
+                REQUIRE(osa.Distance(pair.first, pair.second, maxDistance) ==
+                        (expectedOsa <= maxDistance ? expectedOsa : -1));
+                REQUIRE(levenshtein.Distance(pair.second, pair.first, maxDistance) ==
+                        (expectedLevenshtein <= maxDistance ? expectedLevenshtein : -1));
+            }
+        }
+        REQUIRE(osa.Distance(XL("abcd"), XL("acbd")) == 1);
+        REQUIRE(levenshtein.Distance(XL("abcd"), XL("acbd")) == 2);
+    }
+
+    SECTION("Batched distances match single distances")
+    {
+        xstring input = XL("abolution");
+        std::vector<xstring> words = {XL("absolution"), XL("abolition"), XL("evolution"), XL("ablution"),
+                                      XL("boaltuion"), XL("a"), XL("revolutionary"), XL("abolution"), XL("aboltuion")};
+        PatternMasks masks;
+        masks.Reset(input);
+        for (size_t count = 0; count <= words.size(); count++)
+        {
+            std::vector<xstring_view> texts(words.begin(), words.begin() + count);
+            std::vector<int> osa(count), levenshtein(count);
+            BitVectorDistance::Distances<true>(masks, (int)input.size(), texts.data(), count, 3, osa.data());
+            BitVectorDistance::Distances<false>(masks, (int)input.size(), texts.data(), count, 3, levenshtein.data());
+            for (size_t i = 0; i < count; i++)
+            {
+                REQUIRE(osa[i] == BitVectorDistance::Distance<true>(masks, (int)input.size(), texts[i], 3));
+                REQUIRE(levenshtein[i] == BitVectorDistance::Distance<false>(masks, (int)input.size(), texts[i], 3));
+            }
+        }
+        std::vector<xstring_view> texts(words.begin(), words.end());
+        std::vector<int> osa(texts.size());
+        BitVectorDistance::Distances<true>(masks, (int)input.size(), texts.data(), texts.size(), 3, osa.data());
+        REQUIRE(osa == std::vector<int>{1, 1, 2, 1, 3, -1, -1, 0, 1});
+    }
+
+    SECTION("Levenshtein distance can be selected")
+    {
+        SymSpell osaSymSpell(maxEditDistance, 7);
+        SymSpell levenshteinSymSpell(maxEditDistance, 7, 1, DEFAULT_INITIAL_CAPACITY, DEFAULT_COMPACT_LEVEL,
+                                     DistanceAlgorithm::LevenshteinDistance);
+        REQUIRE(osaSymSpell.GetDistanceAlgorithm() == DistanceAlgorithm::DamerauOSADistance);
+        REQUIRE(levenshteinSymSpell.GetDistanceAlgorithm() == DistanceAlgorithm::LevenshteinDistance);
+        osaSymSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        levenshteinSymSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+
+        // a swap of adjacent characters is one edit for OSA and two for Levenshtein
+        auto results = osaSymSpell.Lookup(XL("teh"), Verbosity::All, 2);
+        auto the = std::find_if(results.begin(), results.end(), [](const SuggestItem &s) { return s.term == XL("the"); });
+        REQUIRE(the != results.end());
+        REQUIRE(the->distance == 1);
+        results = levenshteinSymSpell.Lookup(XL("teh"), Verbosity::All, 2);
+        the = std::find_if(results.begin(), results.end(), [](const SuggestItem &s) { return s.term == XL("the"); });
+        REQUIRE(the != results.end());
+        REQUIRE(the->distance == 2);
+
+        Levenshtein levenshtein;
+        for (const auto &suggestion : levenshteinSymSpell.Lookup(XL("abolution"), Verbosity::All, 2))
+            REQUIRE(suggestion.distance == (int)levenshtein.Distance(XL("abolution"), suggestion.term));
+
+        REQUIRE_THROWS_AS(SymSpell(maxEditDistance, 7, 1, DEFAULT_INITIAL_CAPACITY, DEFAULT_COMPACT_LEVEL,
+                                   (DistanceAlgorithm)7),
+                          std::invalid_argument);
+    }
+
+    SECTION("Lookups reusing a context match fresh lookups")
+    {
+        std::vector<xstring> queries = ReadQueries(200);
+        queries.push_back(XL("Pyhton"));
+        queries.push_back(XL(""));
+
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        LookupContext context;
+        int mismatches = 0;
+        for (Verbosity verbosity : {Verbosity::Top, Verbosity::Closest, Verbosity::All})
+        {
+            for (const xstring &query : queries)
+            {
+                bool transferCasing = query == XL("Pyhton");
+                std::vector<SuggestItem> expected = symSpell.Lookup(query, verbosity, 2, true, transferCasing);
+                const std::vector<SuggestItem> &actual = symSpell.Lookup(query, verbosity, 2, true, transferCasing,
+                                                                        context);
+                if (!SameSuggestions(actual, expected))
+                    mismatches++;
+            }
+        }
+        REQUIRE(mismatches == 0);
+        REQUIRE(symSpell.Lookup(XL("Pyhton"), Verbosity::Top, 2, false, true, context)[0].term == XL("Python"));
+
+        // once the context has grown to the queries, looking them up again doesn't allocate
+        size_t suggestionCount = 0;
+        size_t allocations = allocationCount;
+        for (Verbosity verbosity : {Verbosity::Top, Verbosity::Closest, Verbosity::All})
+        {
+            for (const xstring &query : queries)
+                suggestionCount += symSpell.Lookup(query, verbosity, 2, true, false, context).size();
+        }
+        allocations = allocationCount - allocations;
+        REQUIRE(suggestionCount > queries.size());
+        REQUIRE(allocations == 0);
+        // the overloads without a context hand out a vector of their own
+        allocations = allocationCount;
+        suggestionCount = symSpell.Lookup(queries[0], Verbosity::Closest, 2, true).size();
+        allocations = allocationCount - allocations;
+        REQUIRE(suggestionCount > 0);
+        REQUIRE(allocations > 0);
+    }
+
+    SECTION("Cached lookups match uncached ones and follow dictionary changes")
+    {
+        std::vector<xstring> queries = ReadQueries(200);
+
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        std::vector<std::vector<SuggestItem>> expected;
+        for (const xstring &query : queries)
+            expected.push_back(symSpell.Lookup(query, Verbosity::Closest, 2, true));
+        REQUIRE(symSpell.LookupCacheStats().misses == 0);
+
+        symSpell.EnableLookupCache(1 << 20);
+        int mismatches = 0;
+        for (int round = 0; round < 3; round++)
+        {
+            for (size_t i = 0; i < queries.size(); i++)
+            {
+                std::vector<SuggestItem> results = symSpell.Lookup(queries[i], Verbosity::Closest, 2, true);
+                if (!SameSuggestions(results, expected[i]))
+                    mismatches++;
+            }
+        }
+        REQUIRE(mismatches == 0);
+        // words of the dictionary are answered before the cache is asked
+        size_t unknownQueries = std::count_if(expected.begin(), expected.end(), [](const std::vector<SuggestItem> &e)
+                                              { return e[0].distance != 0; });
+        LookupCache::Stats stats = symSpell.LookupCacheStats();
+        REQUIRE(stats.hits + stats.misses == 3 * unknownQueries);
+        REQUIRE(stats.hits > 0);
+        REQUIRE(stats.entries > 0);
+        REQUIRE(stats.memory <= (1 << 20));
+
+        // the cache is emptied when the dictionary changes
+        REQUIRE(symSpell.Lookup(XL("pyhton"), Verbosity::Top, 2)[0].term == XL("python"));
+        REQUIRE(symSpell.Lookup(XL("pyhton"), Verbosity::Top, 2)[0].term == XL("python"));
+        symSpell.CreateDictionaryEntry(XL("pyhton"), 1, nullptr);
+        REQUIRE(symSpell.LookupCacheStats().entries == 0);
+        REQUIRE(symSpell.Lookup(XL("pyhton"), Verbosity::Top, 2)[0].distance == 0);
+        REQUIRE(symSpell.Lookup(XL("pyhton"), Verbosity::Top, 2)[0].distance == 0);
+        symSpell.DeleteDictionaryEntry(XL("pyhton"));
+        REQUIRE(symSpell.Lookup(XL("pyhton"), Verbosity::Top, 2)[0].term == XL("python"));
+
+        symSpell.EnableLookupCache(0);
+        REQUIRE(symSpell.LookupCacheStats().hits == 0);
+        REQUIRE_THROWS_AS(symSpell.EnableLookupCache(1 << 20, 0), std::invalid_argument);
+    }
+
+    SECTION("Lookup cache keeps frequent keys over one-off keys")
+    {
+        LookupCache cache(32 * 1024, 1);
+        std::vector<SuggestItem> suggestions{SuggestItem(XL("python"), 1, 100)};
+        std::vector<SuggestItem> found;
+        xstring hot = XL("pyhton");
+        for (int i = 0; i < 5000; i++)
+        {
+            xstring cold = XL("cold") + to_xstring(i);
+            LookupCache::Key coldKey{cold, Verbosity::Top, 2, false, false, 0};
+            if (!cache.Find(coldKey, found))
+                cache.Insert(coldKey, suggestions);
+            if (i % 10 == 0)
+            {
+                LookupCache::Key hotKey{hot, Verbosity::Top, 2, false, false, 0};
+                if (!cache.Find(hotKey, found))
+                    cache.Insert(hotKey, suggestions);
+            }
+        }
+        REQUIRE(cache.Find(LookupCache::Key{hot, Verbosity::Top, 2, false, false, 0}, found));
+        REQUIRE(found.size() == 1);
+        REQUIRE(found[0].Equals(suggestions[0]));
+        REQUIRE_FALSE(cache.Find(LookupCache::Key{hot, Verbosity::Closest, 2, false, false, 0}, found));
+        LookupCache::Stats stats = cache.GetStats();
+        REQUIRE(stats.memory <= 32 * 1024);
+        REQUIRE(stats.entries > 1);
+        cache.Clear();
+        REQUIRE(cache.GetStats().entries == 0);
+        REQUIRE_FALSE(cache.Find(LookupCache::Key{hot, Verbosity::Top, 2, false, false, 0}, found));
+    }
+
+    SECTION("TopK returns the first k suggestions of All")
+    {
+        std::vector<xstring> queries = ReadQueries(300);
+        queries.push_back(XL("the"));
+        queries.push_back(XL("huse"));
+
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        int mismatches = 0;
+        for (const xstring &query : queries)
+        {
+            std::vector<SuggestItem> all = symSpell.Lookup(query, Verbosity::All, 2, true);
+            for (int k : {1, 3, 5, 10})
+            {
+                std::vector<SuggestItem> topK = symSpell.Lookup(query, Verbosity::TopK, 2, true, false, k);
+                std::vector<SuggestItem> firstK(all.begin(), all.begin() + std::min(all.size(), (size_t)k));
+                if (!SameSuggestions(topK, firstK))
+                    mismatches++;
+            }
+        }
+        REQUIRE(mismatches == 0);
+
+        auto huse = symSpell.Lookup(XL("huse"), Verbosity::TopK, 2, false, false, 3);
+        REQUIRE(huse.size() == 3);
+        REQUIRE(huse[0].term == XL("use"));
+        REQUIRE(huse[1].term == XL("house"));
+        REQUIRE_THROWS_AS(symSpell.Lookup(XL("huse"), Verbosity::TopK, 2, false, false, 0), std::invalid_argument);
+        // k is ignored by the other verbosities
+        REQUIRE(symSpell.Lookup(XL("huse"), Verbosity::Top, 2, false, false, 0).size() == 1);
+    }
+
+    SECTION("Queries work on views into a larger buffer")
+    {
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        xstring buffer = XL("xxpyhtonxx thequickbrownfox whereis th elove|tail");
+        xstring_view word = xstring_view(buffer).substr(2, 6);
+        auto results = symSpell.Lookup(word, Verbosity::Top, 2);
+        REQUIRE(results.size() == 1);
+        REQUIRE(results[0].term == XL("python"));
+
+        Info segmented = symSpell.WordSegmentation(xstring_view(buffer).substr(11, 16));
+        REQUIRE(segmented.getCorrected() == XL("the quick brown fox"));
+        REQUIRE(symSpell.WordSegmentation(XL("")).getCorrected().empty());
+
+        auto compound = symSpell.LookupCompound(xstring_view(buffer).substr(28, 16), 2);
+        REQUIRE(compound.size() == 1);
+        REQUIRE(compound[0].term == symSpell.LookupCompound(XL("whereis th elove"), 2)[0].term);
+    }
+
+    SECTION("Frozen buckets pruned by length and count give the same suggestions")
+    {
+        // a short prefix makes large buckets holding words of many lengths
+        SymSpell symSpell(2, 3);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        SymSpell frozenSymSpell(2, 3);
+        frozenSymSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        frozenSymSpell.Freeze();
+
+        for (xstring_view word : {XL("tke"), XL("hse"), XL("abolution"), XL("intermedaite"), XL("a")})
+        {
+            for (int editDistance = 1; editDistance <= 2; editDistance++)
+            {
+                for (auto verbosity : {Verbosity::Top, Verbosity::Closest, Verbosity::TopK})
+                {
+                    auto expected = symSpell.Lookup(word, verbosity, editDistance, false, false, 3);
+                    auto results = frozenSymSpell.Lookup(word, verbosity, editDistance, false, false, 3);
+                    REQUIRE(results.size() == expected.size());
+                    for (int i = 0; i < results.size(); i++)
+                        REQUIRE(results[i].Equals(expected[i]));
+                }
+            }
+        }
+    }
+
+    SECTION("Character signatures bound the edit distance from below")
+    {
+        std::vector<xstring> words = {XL("abolution"), XL("absolution"), XL("evolution"), XL("boaltuion"),
+                                      XL("aaaa"), XL("aa"), XL("banana"), XL("nab"), XL(""), XL("a"), XL("zzyzx")};
+        DamerauOSA osa;
+        Levenshtein levenshtein;
+        for (const xstring &word1 : words)
+        {
+            for (const xstring &word2 : words)
+            {
+                int bound = CharSignature::DistanceBound(CharSignature::Of(word1), CharSignature::Of(word2));
+                REQUIRE(bound <= osa.Distance(word1, word2));
+                REQUIRE(bound <= levenshtein.Distance(word1, word2));
+            }
+        }
+        REQUIRE(CharSignature::DistanceBound(CharSignature::Of(XL("abc")), CharSignature::Of(XL("cab"))) == 0);
+        REQUIRE(CharSignature::DistanceBound(CharSignature::Of(XL("aa")), CharSignature::Of(XL("a"))) == 1);
+
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        for (xstring_view word : {XL("abolution"), XL("intermedaite"), XL("elipnaht")})
+            symSpell.Lookup(word, Verbosity::All, 2);
+        LookupStats stats = symSpell.GetLookupStats();
+        REQUIRE(stats.lookups == 3);
+        REQUIRE(stats.signatureRejections > 0);
+        REQUIRE(stats.distanceComputations > 0);
+        symSpell.ResetLookupStats();
+        REQUIRE(symSpell.GetLookupStats().lookups == 0);
+    }
+
+    SECTION("Known words are answered without a search")
+    {
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        std::vector<xstring_view> inputs = {XL("house"), XL("the"), XL("house"), XL("abolution")};
+        for (auto verbosity : {Verbosity::Top, Verbosity::Closest})
+        {
+            symSpell.ResetLookupStats();
+            SuggestionBatch batch = symSpell.LookupBatch(inputs, verbosity, 2, 2);
+            for (size_t i = 0; i < inputs.size(); i++)
+            {
+                auto expected = symSpell.Lookup(inputs[i], verbosity, 2);
+                REQUIRE(batch.End(i) - batch.Begin(i) == (long)expected.size());
+                for (size_t k = 0; k < expected.size(); k++)
+                    REQUIRE(batch.Begin(i)[k].Equals(expected[k]));
+            }
+            REQUIRE(symSpell.GetLookupStats().lookups == 3 + inputs.size());
+        }
+
+        symSpell.ResetLookupStats();
+        auto known = symSpell.Lookup(XL("house"), Verbosity::Closest, 2);
+        REQUIRE(known.size() == 1);
+        REQUIRE(known[0].distance == 0);
+        REQUIRE(symSpell.GetLookupStats().distanceComputations == 0);
+        // All and TopK keep searching past the word itself
+        REQUIRE(symSpell.Lookup(XL("house"), Verbosity::All, 2).size() > 1);
+        REQUIRE(symSpell.Lookup(XL("house"), Verbosity::TopK, 2, false, false, 3).size() == 3);
+        REQUIRE(symSpell.Lookup(XL("House"), Verbosity::Closest, 2, false, true)[0].term == XL("House"));
+        REQUIRE_THROWS_AS(symSpell.Lookup(XL("house"), Verbosity::Top, 3), std::invalid_argument);
+    }
+
+    SECTION("Posting lists keep their ids inline and on the heap alike")
+    {
+        PostingList list;
+        std::vector<uint32_t> expected;
+        for (uint32_t id = 0; id < 3 * PostingList::InlineCapacity; id++)
+        {
+            list.push_back(id * 7);
+            expected.push_back(id * 7);
+            REQUIRE(std::vector<uint32_t>(list.begin(), list.end()) == expected);
+        }
+        list.erase(std::find(list.begin(), list.end(), 7u));
+        expected.erase(std::find(expected.begin(), expected.end(), 7u));
+        REQUIRE(std::vector<uint32_t>(list.begin(), list.end()) == expected);
+
+        PostingList copy = list;
+        PostingList moved = std::move(list);
+        REQUIRE(list.empty());
+        REQUIRE(std::vector<uint32_t>(copy.begin(), copy.end()) == expected);
+        REQUIRE(std::vector<uint32_t>(moved.begin(), moved.end()) == expected);
+
+        PostingList small;
+        small.push_back(1);
+        small.append(expected.begin(), expected.begin() + 2);
+        moved = std::move(small);
+        REQUIRE(std::vector<uint32_t>(moved.begin(), moved.end()) == std::vector<uint32_t>{1, 0, 14});
+        copy = moved;
+        copy.erase(copy.begin());
+        REQUIRE(std::vector<uint32_t>(copy.begin(), copy.end()) == std::vector<uint32_t>{0, 14});
+    }
+
+    SECTION("Frozen and snapshot dictionaries keep their bigrams")
+    {
+        auto bigramPath = "../resources/bigrams.test.txt";
+        {
+            std::ofstream bigramFile(bigramPath);
+            bigramFile << "where is 90000\nthe love 80000\nhe had 70000\nof the 60000\nsixth grade 50000\n";
+        }
+        const xstring input = XL("whereis th elove hehad dated forImuch of thepast who couqdn'tread in sixthgrade");
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        REQUIRE(symSpell.LoadBigramDictionary(bigramPath, 0, 2, XL(' ')));
+        auto expected = symSpell.LookupCompound(input, 2);
+
+        auto snapshotPath = "../resources/bigrams.snapshot";
+        symSpell.SaveSnapshot(snapshotPath);
+        REQUIRE(symSpell.bigrams.empty());
+        SymSpell snapshotSymSpell;
+        snapshotSymSpell.LoadSnapshot(snapshotPath);
+        for (const SymSpell *frozenSymSpell : {&symSpell, &snapshotSymSpell})
+        {
+            auto results = frozenSymSpell->LookupCompound(input, 2);
+            REQUIRE(results.size() == expected.size());
+            REQUIRE(results[0].Equals(expected[0]));
+        }
+
+        // pickles keep the frozen bigrams
+        std::stringstream pickle(std::ios::in | std::ios::out | std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(pickle);
+            archive(symSpell);
+        }
+        SymSpell pickledSymSpell(maxEditDistance, prefixLength);
+        {
+            cereal::BinaryInputArchive archive(pickle);
+            archive(pickledSymSpell);
+        }
+        REQUIRE(pickledSymSpell.IsFrozen());
+        REQUIRE(pickledSymSpell.LookupCompound(input, 2)[0].Equals(expected[0]));
+
+        // bigrams loaded after freezing are used as well
+        SymSpell lateSymSpell;
+        lateSymSpell.LoadSnapshot(snapshotPath);
+        REQUIRE(lateSymSpell.LoadBigramDictionary(bigramPath, 0, 2, XL(' ')));
+        REQUIRE(lateSymSpell.LookupCompound(input, 2)[0].Equals(expected[0]));
+        std::remove(snapshotPath);
+        std::remove(bigramPath);
+    }
+
+    SECTION("Perfect hashes map their keys onto distinct positions")
+    {
+        for (uint64_t keyCount : {1, 2, 3, 100, 5000})
+        {
+            std::vector<uint64_t> keys;
+            for (uint64_t i = 0; i < keyCount; i++)
+                keys.push_back(i * 0x9E3779B97F4A7C15ull + 12345);
+            PerfectHash perfectHash;
+            REQUIRE(perfectHash.Build(keys));
+            std::vector<bool> seen(keyCount, false);
+            for (uint64_t key : keys)
+            {
+                uint32_t position = perfectHash.Index(key);
+                REQUIRE(position < keyCount);
+                REQUIRE_FALSE(seen[position]);
+                seen[position] = true;
+            }
+        }
+        PerfectHash duplicates;
+        REQUIRE_FALSE(duplicates.Build({1, 2, 1}));
+        REQUIRE(duplicates.Empty());
+
+        TermArena arena;
+        std::vector<xstring> words = {XL("the"), XL("quick"), XL("brown"), XL("fox"), XL("jumps"), XL("over")};
+        for (const auto &word : words)
+            arena.Intern(word);
+        arena.Freeze();
+        REQUIRE(arena.Frozen());
+        for (uint32_t id = 0; id < words.size(); id++)
+            REQUIRE(arena.Find(words[id]) == id);
+        REQUIRE(arena.Find(XL("lazy")) == TermArena::npos);
+        REQUIRE(arena.Find(XL("")) == TermArena::npos);
+        REQUIRE_THROWS_AS(arena.Intern(XL("dog")), std::logic_error);
+    }
+
+    SECTION("Compressed postings give the same suggestions")
+    {
+        std::vector<uint32_t> ids = {0, 1, 2, 200, 300, 70000, 70001, 20000000, 4000000000u};
+        for (auto codec : {PostingCodec::Varint, PostingCodec::StreamVByte})
+        {
+            for (size_t count = 0; count <= ids.size(); count++)
+            {
+                std::vector<uint8_t> encoded;
+                PostingCoder::Encode(codec, ids.data(), count, encoded);
+                size_t size = encoded.size();
+                encoded.resize(size + PostingCoder::Padding, 0);
+                std::vector<uint32_t> decoded;
+                PostingCoder::Decode(codec, encoded.data(), size, decoded);
+                REQUIRE(decoded == std::vector<uint32_t>(ids.begin(), ids.begin() + count));
+            }
+        }
+
+        SymSpell symSpell(2, 3);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        REQUIRE(symSpell.GetPostingCodec() == PostingCodec::Raw);
+        REQUIRE(SymSpell(2, 3, 1, 0, 16).GetPostingCodec() == PostingCodec::Varint);
+        for (auto codec : {PostingCodec::Varint, PostingCodec::StreamVByte})
+        {
+            SymSpell frozenSymSpell(2, 3);
+            frozenSymSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+            frozenSymSpell.Freeze(codec);
+            REQUIRE(frozenSymSpell.GetPostingCodec() == codec);
+            frozenSymSpell.SaveSnapshot("../resources/postings.snapshot");
+            SymSpell snapshotSymSpell;
+            snapshotSymSpell.LoadSnapshot("../resources/postings.snapshot");
+            REQUIRE(snapshotSymSpell.GetPostingCodec() == codec);
+            for (xstring_view word : {XL("tke"), XL("hse"), XL("abolution"), XL("intermedaite"), XL("a")})
+            {
+                for (auto verbosity : {Verbosity::Top, Verbosity::Closest, Verbosity::All})
+                {
+                    auto expected = symSpell.Lookup(word, verbosity, 2);
+                    auto results = frozenSymSpell.Lookup(word, verbosity, 2);
+                    auto snapshotResults = snapshotSymSpell.Lookup(word, verbosity, 2);
+                    REQUIRE(results.size() == expected.size());
+                    REQUIRE(snapshotResults.size() == expected.size());
+                    for (int i = 0; i < results.size(); i++)
+                    {
+                        REQUIRE(results[i].Equals(expected[i]));
+                        REQUIRE(snapshotResults[i].Equals(expected[i]));
+                    }
+                }
+            }
+        }
+        std::remove("../resources/postings.snapshot");
+    }
+
+    SECTION("Word infos pack the lengths, count and signature of a word")
+    {
+        WordInfo info = WordInfo::Of(XL("abolution"), 12345, 7);
+        REQUIRE(info.Length() == 9);
+        REQUIRE(info.PrefixLength() == 7);
+        REQUIRE(info.CountBound() == 12345);
+        REQUIRE(info.signature == CharSignature::Of(XL("abolution")));
+        REQUIRE(WordInfo::Of(XL("tke"), 1, 7).PrefixLength() == 3);
+
+        // saturated counts only bound the count from above, a deleted word counts nothing
+        info.SetCount(int64_t(1) << 40);
+        REQUIRE(info.CountBound() >= int64_t(1) << 40);
+        info.SetCount(UINT32_MAX - 1);
+        REQUIRE(info.CountBound() == UINT32_MAX - 1);
+        info.SetCount(-1);
+        REQUIRE(info.CountBound() == 0);
+    }
+
+    SECTION("Pickles carry a format version and old ones are rejected")
+    {
+        SymSpell symSpell(maxEditDistance, prefixLength);
+        symSpell.LoadDictionary("../resources/frequency_dictionary_en_82_765.txt", 0, 1, XL(' '));
+        auto expected = symSpell.Lookup(XL("tke"), Verbosity::Closest);
+
+        std::stringstream pickle(std::ios::in | std::ios::out | std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(pickle);
+            archive(symSpell);
+        }
+        SymSpell loaded(maxEditDistance, prefixLength);
+        {
+            cereal::BinaryInputArchive archive(pickle);
+            archive(loaded);
+        }
+        auto results = loaded.Lookup(XL("tke"), Verbosity::Closest);
+        REQUIRE(results.size() == expected.size());
+        for (int i = 0; i < results.size(); i++)
+            REQUIRE(results[i].Equals(expected[i]));
+
+        // loading a pickle empties the lookup cache
+        SymSpell cached(maxEditDistance, prefixLength);
+        cached.CreateDictionaryEntry(XL("tie"), 1, nullptr);
+        cached.EnableLookupCache(1 << 20);
+        REQUIRE(cached.Lookup(XL("tke"), Verbosity::Closest)[0].term == XL("tie"));
+        pickle.clear();
+        pickle.seekg(0);
+        {
+            cereal::BinaryInputArchive archive(pickle);
+            archive(cached);
+        }
+        REQUIRE(cached.LookupCacheStats().entries == 0);
+        REQUIRE(expected[0].term != XL("tie"));
+        REQUIRE(cached.Lookup(XL("tke"), Verbosity::Closest)[0].term == expected[0].term);
+
+        // the unversioned layout of earlier releases
+        std::stringstream oldPickle(std::ios::in | std::ios::out | std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(oldPickle);
+            auto oldDeletes = std::make_shared<std::unordered_map<int, std::vector<xstring>>>();
+            (*oldDeletes)[42].push_back(XL("tke"));
+            std::unordered_map<xstring, int64_t> oldWords = {{XL("the"), 10}};
+            archive(oldDeletes, oldWords, 3);
+        }
+        {
+            cereal::BinaryInputArchive archive(oldPickle);
+            REQUIRE_THROWS_AS(archive(loaded), std::invalid_argument);
+        }
+
+        // a pickle of the first versioned format
+        std::stringstream olderPickle(std::ios::in | std::ios::out | std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(olderPickle);
+            archive(uint32_t(1));
+        }
+        {
+            cereal::BinaryInputArchive archive(olderPickle);
+            REQUIRE_THROWS_WITH(archive(loaded), Catch::Contains("Pickle format 1 is no longer supported"));
+        }
+        results = loaded.Lookup(XL("tke"), Verbosity::Closest);
+        REQUIRE(results.size() == expected.size());
+        REQUIRE(loaded.WordCount() == symSpell.WordCount());
+    }
+}
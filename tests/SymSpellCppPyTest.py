@@ -1,7 +1,8 @@
 import unittest
-from SymSpellCppPy import SymSpell, Verbosity, SuggestItem
+from SymSpellCppPy import SymSpell, Verbosity, SuggestItem, DistanceAlgorithm, PostingCodec
 import os
 import sys
+from concurrent.futures import ThreadPoolExecutor
 
 
 class SymSpellCppPyTests(unittest.TestCase):
@@ -21,6 +22,7 @@ class SymSpellCppPyTests(unittest.TestCase):
         self.assertRaisesRegex(ValueError, ".*prefix_length.*", SymSpell, 1, 0)
         self.assertRaisesRegex(ValueError, ".*prefix_length.*", SymSpell, 1, -1)
         self.assertRaisesRegex(ValueError, ".*prefix_length.*", SymSpell, 2, 2)
+        self.assertRaisesRegex(ValueError, ".*prefix_length.*", SymSpell, 2, 65)
 
     def test_negative_count_threshold(self):
         self.assertRaisesRegex(ValueError, ".*count_threshold.*", SymSpell, 1, 3, -1)
@@ -576,6 +578,15 @@ class SymSpellCppPyTests(unittest.TestCase):
         self.assertEqual("ball", sym_spell_ld.lookup("boll", Verbosity.CLOSEST)[0].term)
         self.assertEqual(2, sym_spell_ld.lookup("c0d3", Verbosity.CLOSEST)[0].distance)
 
+    def test_pickle_unversioned(self):
+        sym_spell = SymSpell(2, 7)
+        sym_spell.create_dictionary_entry("test", 123)
+        # earlier releases started their pickles with the delete index instead of a format version
+        old_bytes = b"\x01\x00\x00\x80" + bytes(16)
+        with self.assertRaises(ValueError):
+            sym_spell.load_pickle_bytes(old_bytes)
+        self.assertEqual("test", sym_spell.lookup("tst", Verbosity.CLOSEST)[0].term)
+
     def test_delete_dictionary_entry(self):
         sym_spell = SymSpell()
         sym_spell.create_dictionary_entry("stea", 1)
@@ -736,6 +747,147 @@ class SymSpellCppPyTests(unittest.TestCase):
                                   transfer_casing=True)
         self.assertEqual("I", result[0].term)
 
+    def test_freeze(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        expected = sym_spell.lookup("tke", Verbosity.ALL, 2)
+        entry_count = sym_spell.entry_count()
+
+        sym_spell.freeze()
+        self.assertTrue(sym_spell.is_frozen())
+        self.assertEqual(entry_count, sym_spell.entry_count())
+        self.assertEqual(expected, sym_spell.lookup("tke", Verbosity.ALL, 2))
+        self.assertRaises(RuntimeError, sym_spell.create_dictionary_entry, "tke", 1)
+
+    def test_snapshot(self):
+        snapshot_path = os.path.join(self.fortests_path, "dictionary.snapshot")
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        sym_spell.save_snapshot(snapshot_path)
+        self.assertTrue(sym_spell.is_frozen())
+
+        sym_spell_2 = SymSpell()
+        sym_spell_2.load_snapshot(snapshot_path)
+        self.assertTrue(sym_spell_2.is_frozen())
+        self.assertEqual(sym_spell.word_count(), sym_spell_2.word_count())
+        self.assertEqual(sym_spell.entry_count(), sym_spell_2.entry_count())
+        self.assertEqual(sym_spell.max_length(), sym_spell_2.max_length())
+        self.assertEqual(sym_spell.lookup("tke", Verbosity.ALL, 2), sym_spell_2.lookup("tke", Verbosity.ALL, 2))
+        del sym_spell_2
+        os.remove(snapshot_path)
+
+    def test_freeze_posting_codecs(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        expected = sym_spell.lookup("tke", Verbosity.ALL, 2)
+        self.assertEqual(PostingCodec.RAW, sym_spell.posting_codec())
+        self.assertEqual(PostingCodec.VARINT, SymSpell(compact_level=16).posting_codec())
+        for codec in (PostingCodec.RAW, PostingCodec.VARINT, PostingCodec.STREAM_VBYTE):
+            frozen = SymSpell()
+            frozen.load_dictionary(self.dictionary_path, 0, 1)
+            frozen.freeze(codec)
+            self.assertEqual(codec, frozen.posting_codec())
+            self.assertEqual(expected, frozen.lookup("tke", Verbosity.ALL, 2))
+
+    def test_load_snapshot_invalid_file(self):
+        sym_spell = SymSpell()
+        self.assertRaises(ValueError, sym_spell.load_snapshot, self.dictionary_path)
+        self.assertRaises(ValueError, sym_spell.load_snapshot, "invalid/snapshot/path")
+
+    def test_load_dictionary_threads(self):
+        snapshots = []
+        for threads in (1, 4):
+            snapshot_path = os.path.join(self.fortests_path, "dictionary_%d.snapshot" % threads)
+            sym_spell = SymSpell()
+            self.assertTrue(sym_spell.load_dictionary(self.dictionary_path, 0, 1, threads=threads))
+            sym_spell.save_snapshot(snapshot_path)
+            with open(snapshot_path, "rb") as snapshot:
+                snapshots.append(snapshot.read())
+            os.remove(snapshot_path)
+        self.assertEqual(snapshots[0], snapshots[1])
+        self.assertRaises(ValueError, SymSpell().load_dictionary, self.dictionary_path, 0, 1, threads=-1)
+
+    def test_lookup_from_threads(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        queries = ["tke", "abolution", "intermedaite", "the", "elipnaht"] * 50
+        expected = [sym_spell.lookup(query, Verbosity.CLOSEST, 2) for query in queries]
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            results = list(pool.map(lambda query: sym_spell.lookup(query, Verbosity.CLOSEST, 2), queries))
+        self.assertEqual(expected, results)
+
+    def test_lookup_batch(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        queries = ["tke", "abolution", "intermedaite", "the", "elipnaht", "zzzzzzzz"] * 20
+        expected = [sym_spell.lookup(query, Verbosity.CLOSEST, 2, True) for query in queries]
+        for threads in [1, 4]:
+            batch = sym_spell.lookup_batch(queries, Verbosity.CLOSEST, 2, threads=threads, include_unknown=True)
+            self.assertEqual(len(batch), len(queries))
+            self.assertEqual(list(batch), expected)
+            self.assertEqual(batch[-1], expected[-1])
+            self.assertEqual(len(batch.offsets), 7)
+        with self.assertRaises(IndexError):
+            batch[len(queries)]
+        self.assertEqual(len(sym_spell.lookup_batch([], Verbosity.TOP)), 0)
+        with self.assertRaises(ValueError):
+            sym_spell.lookup_batch(queries, Verbosity.TOP, 3)
+
+    def test_distance_algorithm(self):
+        osa = SymSpell()
+        levenshtein = SymSpell(distance_algorithm=DistanceAlgorithm.LEVENSHTEIN)
+        self.assertEqual(osa.distance_algorithm(), DistanceAlgorithm.DAMERAU_OSA)
+        self.assertEqual(levenshtein.distance_algorithm(), DistanceAlgorithm.LEVENSHTEIN)
+        osa.load_dictionary(self.dictionary_path, 0, 1)
+        levenshtein.load_dictionary(self.dictionary_path, 0, 1)
+        osa_distances = {s.term: s.distance for s in osa.lookup("teh", Verbosity.ALL, 2)}
+        levenshtein_distances = {s.term: s.distance for s in levenshtein.lookup("teh", Verbosity.ALL, 2)}
+        self.assertEqual(osa_distances["the"], 1)
+        self.assertEqual(levenshtein_distances["the"], 2)
+
+    def test_lookup_cache(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        expected = sym_spell.lookup("pyhton", Verbosity.CLOSEST, 2)
+        sym_spell.enable_lookup_cache(1 << 20)
+        for _ in range(3):
+            self.assertEqual(sym_spell.lookup("pyhton", Verbosity.CLOSEST, 2), expected)
+        stats = sym_spell.lookup_cache_stats()
+        self.assertEqual(stats.hits + stats.misses, 3)
+        self.assertGreater(stats.hits, 0)
+        self.assertEqual(stats.entries, 1)
+        self.assertGreater(stats.memory, 0)
+        sym_spell.create_dictionary_entry("pyhton", 1)
+        self.assertEqual(sym_spell.lookup_cache_stats().entries, 0)
+        self.assertEqual(sym_spell.lookup("pyhton", Verbosity.CLOSEST, 2)[0].distance, 0)
+        sym_spell.enable_lookup_cache(0)
+        self.assertEqual(sym_spell.lookup_cache_stats().hits, 0)
+
+    def test_lookup_top_k(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        for query in ["huse", "abolution", "the", "zzzzzzzz"]:
+            expected = sym_spell.lookup(query, Verbosity.ALL, 2)
+            for k in [1, 3, 5]:
+                self.assertEqual(sym_spell.lookup(query, Verbosity.TOP_K, 2, k=k), expected[:k])
+        self.assertEqual([s.term for s in sym_spell.lookup("huse", Verbosity.TOP_K, 2, k=2)], ["use", "house"])
+        batch = sym_spell.lookup_batch(["huse", "huse"], Verbosity.TOP_K, 2, k=3)
+        self.assertEqual(list(batch[0]), sym_spell.lookup("huse", Verbosity.ALL, 2)[:3])
+        with self.assertRaises(ValueError):
+            sym_spell.lookup("huse", Verbosity.TOP_K, 2, k=0)
+
+    def test_lookup_stats(self):
+        sym_spell = SymSpell()
+        sym_spell.load_dictionary(self.dictionary_path, 0, 1)
+        for query in ["abolution", "intermedaite", "elipnaht"]:
+            sym_spell.lookup(query, Verbosity.ALL, 2)
+        stats = sym_spell.lookup_stats()
+        self.assertEqual(stats.lookups, 3)
+        self.assertGreater(stats.distance_computations, 0)
+        self.assertGreater(stats.signature_rejections, 0)
+        sym_spell.reset_lookup_stats()
+        self.assertEqual(sym_spell.lookup_stats().lookups, 0)
+
     def test_empty_deletes(self):
         self.assertEqual(SymSpell(2).lookup("ab", Verbosity.CLOSEST), [])
         self.assertEqual(SymSpell().entry_count(), 0)